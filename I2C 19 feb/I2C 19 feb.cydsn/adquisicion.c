@@ -0,0 +1,452 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "adquisicion.h"
+#include "timebase.h"
+#include "sched.h"
+#include "cyapicallbacks.h"
+#include "perfil.h"
+#include "captura.h"
+#include "alarma.h"
+
+//La adquisicion corre entera por interrupciones y sirve para cualquier sensor de
+//sensor.h (el modelo se elige al compilar): isr_timer arranca cada muestra
+//y I2C_ISR encadena las transacciones (puntero + lectura de 2 bytes por registro).
+//isr_timer e I2C_ISR tienen la misma prioridad (7), asi que no se interrumpen
+//entre si y pueden compartir la maquina de estados sin secciones criticas.
+//Hacia las tareas solo salen datos por cola_muestras y cola_eventos.
+//Todo lo que corre dentro de las interrupciones esta en SRAM (EN_RAM).
+//En modo disparado (bajo consumo) cada muestra empieza escribiendo el registro
+//de configuracion, que arranca una sola conversion; despues de esperar el tiempo
+//de conversion se leen los registros y el sensor queda apagado hasta el proximo.
+//En modo rapido (captura de formas de onda) el sensor convierte solo el shunt con
+//la conversion mas corta; el puntero queda fijo en 0x01 y cada tick es una lectura de 2 bytes sin
+//escribir el puntero. Cada "divisor" lecturas una pasa a cola_muestras con el
+//ultimo voltaje de bus, para que el resto del medidor siga reportando.
+//En modo dual (eficiencia de convertidores) hay un segundo sensor en
+//SlaveAddressSalida. Cada muestra dispara una conversion en los dos, una escritura
+//de configuracion detras de la otra, espera el tiempo de conversion y lee los dos:
+//las conversiones quedan alineadas salvo el tiempo de la segunda escritura
+//(~0.4 ms a 100 kHz), que se mide en us con Timer_1 y sale en el par. El sensor de
+//entrada sigue alimentando cola_muestras y el par va a cola_pares.
+
+enum
+{
+    PASO_LIBRE = 0u,    //esperando el siguiente periodo
+    PASO_INICIAR,       //hay que escribir el puntero o la configuracion (o reintentar)
+    PASO_CONFIG,        //escritura del registro de configuracion en curso
+    PASO_CONVERSION,    //modo disparado: esperando que termine la conversion
+    PASO_PUNTERO,       //escritura del puntero en curso
+    PASO_LECTURA,       //lectura de 2 bytes en curso
+    PASO_RAPIDA         //modo rapido: lectura del shunt con el puntero ya fijo
+};
+
+static const uint8 registros[] = {SENSOR_REG_SHUNT, SENSOR_REG_BUS};
+#define N_REGISTROS     (sizeof(registros)/sizeof(registros[0]))
+static const uint8 direcciones[] = {SlaveAddress, SlaveAddressSalida};
+
+Ring_Crudo  cola_muestras;
+Ring_Evento cola_eventos;
+Ring_Par    cola_pares;
+
+static volatile uint8 paso = PASO_LIBRE;
+static uint8  indice;
+static uint8  puntero;
+static uint8  lectura[2];
+static uint16 valores[N_REGISTROS];
+static uint16 divisor;
+static uint16 cuenta;
+static uint8  tarea_aviso;
+static uint16 config_ina;
+static uint8  config[3];            //puntero 0x00 + configuracion a escribir
+static volatile uint8 escribir_config;
+static volatile uint8 disparado;
+static uint16 espera;               //ticks que faltan para terminar la conversion
+static uint16 espera_conversion;
+static volatile uint8 rapido;
+static uint8  puntero_fijo;         //modo rapido: el sensor ya apunta al shunt
+static uint32 entrada_isr;          //DWT CYCCNT al entrar a I2C_ISR
+static uint32 inicio_muestra;       //DWT CYCCNT al arrancar la muestra en curso
+static volatile uint32 ocupado_us;  //tiempo acumulado con una muestra en curso
+static volatile uint8 dual;
+static uint8  dual_muestra;         //modo dual con que arranco la muestra en curso
+static uint8  canal;                //sensor de la transaccion en curso (0 salvo en modo dual)
+static uint32 disparo[2];           //Timebase_Us() al terminar la escritura que dispara cada sensor
+static Par    par;
+
+EN_RAM static void Evento(uint8 tipo, uint8 reg, uint8 estado){
+    Evento_I2C e;
+
+    e.t_us=Timebase_Us();
+    e.t_ms=Timebase_Now();
+    e.tipo=tipo;
+    e.registro=reg;
+    e.estado=estado;
+    (void)Ring_Evento_Push(&cola_eventos,e);
+}
+
+//Intenta arrancar la transaccion pendiente; si el bus todavia no se libero
+//queda en PASO_INICIAR y se reintenta en la proxima interrupcion
+EN_RAM static void Iniciar(void){
+    (void)I2C_MasterClearStatus();
+    if(escribir_config!=0u){
+        if(I2C_MasterWriteBuf(direcciones[canal],config,3u,I2C_MODE_COMPLETE_XFER)==I2C_MSTR_NO_ERROR){
+            paso=PASO_CONFIG;
+        }
+        return;
+    }
+    puntero=registros[indice];
+    if(I2C_MasterWriteBuf(direcciones[canal],&puntero,1u,I2C_MODE_NO_STOP)==I2C_MSTR_NO_ERROR){
+        paso=PASO_PUNTERO;
+    }
+}
+
+//Arranca una muestra; en modo disparado empieza por la escritura que dispara la conversion
+EN_RAM static void Empezar(void){
+    inicio_muestra=DWT->CYCCNT;
+    indice=0u;
+    canal=0u;
+    dual_muestra=dual;
+    if((disparado!=0u) || (dual_muestra!=0u)){
+        escribir_config=1u;
+    }
+    paso=PASO_INICIAR;
+    PERFIL_INICIO(PF_I2C);
+    Iniciar();
+}
+
+EN_RAM static void Muestra_Completa(void){
+    Crudo c;
+
+    c.t_us=Timebase_Us();
+    c.t_ms=Timebase_Now();
+    if(dual_muestra!=0u){
+        //los valores son los del sensor de salida; el de entrada quedo en el par
+        par.t_ms=c.t_ms;
+        par.t_us=c.t_us;
+        par.shunt[1]=valores[0];
+        par.bus[1]=Sensor_Bus(valores[1]);
+        par.sesgo_us=(uint16)(disparo[1]-disparo[0]);
+        (void)Ring_Par_Push(&cola_pares,par);
+        c.shunt=par.shunt[0];
+        c.bus=par.bus[0];
+    }else{
+        c.shunt=valores[0];
+        c.bus=Sensor_Bus(valores[1]);
+    }
+    Alarma_Evaluar(c.shunt,c.bus,entrada_isr);
+    ocupado_us+=(DWT->CYCCNT-inicio_muestra)/cydelay_freq_mhz;
+    (void)Ring_Crudo_Push(&cola_muestras,c);
+    PERFIL_FIN(PF_I2C);
+    Sched_Signal(tarea_aviso);
+}
+
+//Modo rapido: la lectura va a la captura y una de cada "divisor" a las tareas
+EN_RAM static void Entregar_Rapida(uint16 shunt){
+    Crudo c;
+
+    Captura_Agregar(shunt);
+    Alarma_Evaluar(shunt,Sensor_Bus(valores[1]),entrada_isr);
+    if(++cuenta<divisor){
+        return;
+    }
+    cuenta=0u;
+    c.t_us=Timebase_Us();
+    c.t_ms=Timebase_Now();
+    c.shunt=shunt;
+    c.bus=Sensor_Bus(valores[1]);
+    (void)Ring_Crudo_Push(&cola_muestras,c);
+    Sched_Signal(tarea_aviso);
+}
+
+EN_RAM static void Abortar(uint8 estado){
+    if(rapido==0u){
+        ocupado_us+=(DWT->CYCCNT-inicio_muestra)/cydelay_freq_mhz;
+    }
+    puntero_fijo=0u;
+    canal=0u;
+    Evento(EV_I2C_ERROR,(paso==PASO_CONFIG) ? 0x00u : registros[indice],estado);
+    (void)I2C_MasterClearStatus();
+    paso=PASO_LIBRE;
+}
+
+//Se llama al entrar a I2C_ISR (I2C_ISR_ENTRY_CALLBACK): origen de la latencia de las alarmas
+EN_RAM void I2C_ISR_EntryCallback(void){
+    entrada_isr=DWT->CYCCNT;
+}
+
+//Se llama al final de cada I2C_ISR (I2C_ISR_EXIT_CALLBACK en cyapicallbacks.h)
+EN_RAM void I2C_ISR_ExitCallback(void){
+    uint8 estado;
+
+    PERFIL_INICIO(PF_ISR_I2C);
+    switch(paso){
+        case PASO_CONFIG:
+            estado=I2C_MasterStatus();
+            if((estado & I2C_MSTAT_ERR_MASK)!=0u){
+                Abortar(estado);
+            }else if((estado & I2C_MSTAT_WR_CMPLT)!=0u){
+                (void)I2C_MasterClearStatus();
+                if(dual_muestra!=0u){
+                    //la conversion arranca al terminar la escritura: dispara el
+                    //segundo sensor enseguida. La marca va en us de Timer_1: entre
+                    //los dos disparos el gobernador puede cambiar el reloj de bus,
+                    //y los ciclos del DWT no se podrian convertir con uno solo
+                    disparo[canal]=Timebase_Us();
+                    if(canal==0u){
+                        canal=1u;
+                        paso=PASO_INICIAR;
+                        Iniciar();
+                        break;
+                    }
+                    canal=0u;
+                }
+                escribir_config=0u;
+                if((disparado!=0u) || (dual_muestra!=0u)){
+                    espera=espera_conversion;
+                    paso=PASO_CONVERSION;
+                }else{
+                    paso=PASO_INICIAR;
+                    Iniciar();
+                }
+            }
+            break;
+        case PASO_PUNTERO:
+            estado=I2C_MasterStatus();
+            if((estado & I2C_MSTAT_ERR_MASK)!=0u){
+                Abortar(estado);
+            }else if((estado & I2C_MSTAT_WR_CMPLT)!=0u){
+                (void)I2C_MasterClearStatus();
+                if(I2C_MasterReadBuf(direcciones[canal],lectura,2u,I2C_MODE_REPEAT_START)==I2C_MSTR_NO_ERROR){
+                    paso=PASO_LECTURA;
+                }else{
+                    Abortar(estado);
+                }
+            }
+            break;
+        case PASO_LECTURA:
+            estado=I2C_MasterStatus();
+            if((estado & I2C_MSTAT_ERR_MASK)!=0u){
+                Abortar(estado);
+            }else if((estado & I2C_MSTAT_RD_CMPLT)!=0u){
+                valores[indice]=(uint16)(((uint16)lectura[0]<<8) | lectura[1]);
+                if(rapido!=0u){
+                    //primera lectura del modo rapido: el puntero ya quedo en el shunt
+                    (void)I2C_MasterClearStatus();
+                    puntero_fijo=1u;
+                    paso=PASO_LIBRE;
+                    Entregar_Rapida(valores[0]);
+                    break;
+                }
+                Evento(EV_I2C_OK,registros[indice],estado);
+                indice++;
+                if(indice<N_REGISTROS){
+                    paso=PASO_INICIAR;
+                    Iniciar();
+                }else if((dual_muestra!=0u) && (canal==0u)){
+                    par.shunt[0]=valores[0];
+                    par.bus[0]=Sensor_Bus(valores[1]);
+                    canal=1u;
+                    indice=0u;
+                    paso=PASO_INICIAR;
+                    Iniciar();
+                }else{
+                    (void)I2C_MasterClearStatus();
+                    paso=PASO_LIBRE;
+                    Muestra_Completa();
+                }
+            }
+            break;
+        case PASO_RAPIDA:
+            estado=I2C_MasterStatus();
+            if((estado & I2C_MSTAT_ERR_MASK)!=0u){
+                Abortar(estado);
+            }else if((estado & I2C_MSTAT_RD_CMPLT)!=0u){
+                (void)I2C_MasterClearStatus();
+                paso=PASO_LIBRE;
+                Entregar_Rapida((uint16)(((uint16)lectura[0]<<8) | lectura[1]));
+            }
+            break;
+        case PASO_INICIAR:
+            Iniciar();
+            break;
+        default:
+            break;
+    }
+    PERFIL_FIN(PF_ISR_I2C);
+}
+
+//Se llama en cada tick de isr_timer
+EN_RAM void Adquisicion_Tick(void){
+    if(paso==PASO_INICIAR){
+        Iniciar();
+    }else if((paso==PASO_CONVERSION) && (--espera==0u)){
+        paso=PASO_INICIAR;
+        Iniciar();
+    }
+    if(rapido!=0u){
+        if(paso!=PASO_LIBRE){
+            Captura_Perdida();
+        }else if(puntero_fijo!=0u){
+            (void)I2C_MasterClearStatus();
+            if(I2C_MasterReadBuf(SlaveAddress,lectura,2u,I2C_MODE_COMPLETE_XFER)==I2C_MSTR_NO_ERROR){
+                paso=PASO_RAPIDA;
+            }
+        }else{
+            Empezar();
+        }
+        return;
+    }
+    if(disparado!=0u){
+        return;     //las muestras las pide Adquisicion_Disparar
+    }
+    if(++cuenta<divisor){
+        return;
+    }
+    cuenta=0u;
+    if(paso!=PASO_LIBRE){
+        Evento(EV_I2C_SOLAPE,registros[indice],0u);
+        return;
+    }
+    Empezar();
+}
+
+static void Armar_Config(void){
+    uint16 c=config_ina;
+    uint32 us;
+
+    if(rapido!=0u){
+        c=Sensor_Config_Rapido(c);
+    }else if((disparado!=0u) || (dual!=0u)){
+        c=Sensor_Config_Disparado(c);
+    }
+    config[0]=0x00u;
+    config[1]=(uint8)(c>>8);
+    config[2]=(uint8)(c & 0xFFu);
+    us=Sensor_Conversion_us(config_ina);
+    espera_conversion=(uint16)((us/1000u)+2u);     //+1 por redondeo y +1 porque el tick en curso ya empezo
+}
+
+//Modo disparado para bajo consumo: el sensor convierte solo cuando se pide una
+//muestra y queda apagado entre muestras. Al volver a continuo se reescribe la
+//configuracion en la proxima muestra.
+void Adquisicion_SetDisparado(uint8 on){
+    uint8 estado=CyEnterCriticalSection();
+
+    disparado=on;
+    Armar_Config();
+    escribir_config=1u;
+    CyExitCriticalSection(estado);
+}
+
+//Modo rapido para la captura: una lectura del shunt por tick (1 kHz). Al salir
+//se reescribe la configuracion normal y se vuelve a leer shunt y bus.
+void Adquisicion_SetRapido(uint8 on){
+    uint8 estado=CyEnterCriticalSection();
+
+    rapido=on;
+    puntero_fijo=0u;
+    Armar_Config();
+    escribir_config=1u;
+    CyExitCriticalSection(estado);
+}
+
+//Cambia el registro de configuracion en marcha (barrido del ADC); se escribe al
+//empezar la proxima muestra
+void Adquisicion_SetConfig(uint16 ina_config){
+    uint8 estado=CyEnterCriticalSection();
+
+    config_ina=ina_config;
+    Armar_Config();
+    escribir_config=1u;
+    CyExitCriticalSection(estado);
+}
+
+//Modo eficiencia: lectura de los dos sensores en paso (ver arriba). Al salir se
+//reescribe la configuracion continua en el de entrada; el de salida queda apagado
+//despues de su ultima conversion disparada.
+void Adquisicion_SetDual(uint8 on){
+    uint8 estado=CyEnterCriticalSection();
+
+    dual=on;
+    Armar_Config();
+    escribir_config=1u;
+    CyExitCriticalSection(estado);
+}
+
+uint8 Adquisicion_Dual(void){
+    return dual;
+}
+
+//Tiempo total con una muestra en curso (escrituras, lecturas y esperas del
+//I2C), en us; corre libre como los contadores de la cola
+uint32 Adquisicion_Ocupado_us(void){
+    return ocupado_us;
+}
+
+//Pide una muestra ya (modo disparado). Devuelve 0 si la anterior sigue en curso.
+uint8 Adquisicion_Disparar(void){
+    uint8 estado=CyEnterCriticalSection();
+    uint8 ok=0u;
+
+    if(paso==PASO_LIBRE){
+        Empezar();
+        ok=1u;
+    }
+    CyExitCriticalSection(estado);
+    return ok;
+}
+
+//1 si no hay ninguna transaccion en curso (se puede dormir el I2C)
+uint8 Adquisicion_Libre(void){
+    return (paso==PASO_LIBRE) ? 1u : 0u;
+}
+
+//1 si hay una transferencia I2C en el bus; la espera de la conversion y el
+//reintento pendiente no cuentan (se puede cambiar el reloj del I2C)
+uint8 Adquisicion_Transfiriendo(void){
+    uint8 p=paso;
+
+    return ((p==PASO_CONFIG) || (p==PASO_PUNTERO) || (p==PASO_LECTURA) || (p==PASO_RAPIDA)) ? 1u : 0u;
+}
+
+//Cambia la tasa de muestreo en marcha (la escritura de 16 bits es atomica)
+void Adquisicion_SetRate(uint16 hz){
+    uint16 d=(uint16)(TIMEBASE_TICK_HZ/((hz!=0u) ? hz : 1u));
+
+    divisor=(d!=0u) ? d : 1u;
+}
+
+//Escribe la configuracion (bloqueante, antes de habilitar la cadena por
+//interrupciones) y engancha la adquisicion al tick
+void Adquisicion_Start(uint16 hz, uint16 ina_config, uint8 tarea){
+    uint8 result;
+
+    tarea_aviso=tarea;
+    config_ina=ina_config;
+    disparado=0u;
+    escribir_config=0u;
+    Armar_Config();
+    Adquisicion_SetRate(hz);
+    cuenta=(uint16)(divisor-1u);   //la primera muestra arranca en el proximo tick
+    result=I2C_MasterSendStart(SlaveAddress,I2C_WRITE_XFER_MODE);
+    if(result==I2C_MSTR_NO_ERROR){
+        (void)I2C_MasterWriteByte(0x00u);
+        (void)I2C_MasterWriteByte((uint8)(ina_config>>8));
+        (void)I2C_MasterWriteByte((uint8)(ina_config & 0xFFu));
+    }else{
+        Evento(EV_I2C_ERROR,0x00u,result);
+    }
+    (void)I2C_MasterSendStop();
+    Timebase_SetHook(Adquisicion_Tick);
+}
+
+/* [] END OF FILE */
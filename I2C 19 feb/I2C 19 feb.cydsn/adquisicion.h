@@ -0,0 +1,81 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef ADQUISICION_H
+#define ADQUISICION_H
+
+#include "project.h"
+#include "ringbuf.h"
+#include "ramfunc.h"
+#include "sensor.h"
+
+#define SlaveAddress        SENSOR_DIRECCION    //Dirección esclavo del sensor (sensor.h)
+#define SlaveAddressSalida  SENSOR_DIRECCION_SALIDA //lado de salida en el modo eficiencia
+
+//Lectura cruda del sensor, tal como sale de los registros
+typedef struct
+{
+    uint32 t_ms;        //tick en que se completo la lectura
+    uint32 t_us;        //el mismo instante en us (Timebase_Us)
+    uint16 shunt;       //registro 0x01 (shunt, o corriente en el INA260)
+    uint16 bus;         //registro 0x02 ya pasado por Sensor_Bus()
+} Crudo;
+
+//Eventos de fin de transaccion que genera I2C_ISR
+enum
+{
+    EV_I2C_OK = 0u,     //lectura de un registro completa
+    EV_I2C_ERROR,       //la transaccion termino con error (estado en "estado")
+    EV_I2C_SOLAPE       //llego el siguiente periodo sin terminar la muestra anterior
+};
+
+typedef struct
+{
+    uint32 t_ms;
+    uint32 t_us;
+    uint8  tipo;
+    uint8  registro;
+    uint8  estado;      //I2C_MasterStatus() al terminar
+} Evento_I2C;
+
+//Modo eficiencia: un par de lecturas de los dos sensores disparados juntos
+typedef struct
+{
+    uint32 t_ms;
+    uint32 t_us;
+    uint16 shunt[2];    //[0] entrada (SlaveAddress), [1] salida (SlaveAddressSalida)
+    uint16 bus[2];
+    uint16 sesgo_us;    //entre el disparo de la conversion de uno y del otro
+} Par;
+
+RING_DEFINIR(Ring_Crudo, Crudo, 16u)
+RING_DEFINIR(Ring_Evento, Evento_I2C, 16u)
+RING_DEFINIR(Ring_Par, Par, 8u)
+
+extern Ring_Crudo  cola_muestras;
+extern Ring_Evento cola_eventos;
+extern Ring_Par    cola_pares;
+
+void Adquisicion_Start(uint16 hz, uint16 ina_config, uint8 tarea);
+void Adquisicion_SetRate(uint16 hz);
+void  Adquisicion_SetDisparado(uint8 on);
+void  Adquisicion_SetRapido(uint8 on);
+void  Adquisicion_SetConfig(uint16 ina_config);
+void  Adquisicion_SetDual(uint8 on);
+uint8 Adquisicion_Dual(void);
+uint32 Adquisicion_Ocupado_us(void);
+uint8 Adquisicion_Disparar(void);
+uint8 Adquisicion_Libre(void);
+uint8 Adquisicion_Transfiriendo(void);
+EN_RAM void Adquisicion_Tick(void);
+
+#endif /* ADQUISICION_H */
+/* [] END OF FILE */
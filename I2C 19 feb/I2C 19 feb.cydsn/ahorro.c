@@ -0,0 +1,156 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "ahorro.h"
+#include "adquisicion.h"
+#include "timebase.h"
+#include "config.h"
+#include "consola.h"
+
+#define CARACTER_US         1100u   //un caracter a 9600 baud, para que salga el ultimo
+
+static volatile uint8  estado = AHORRO_APAGADO;
+static volatile uint32 t_ctw;           //tick del ultimo evento del CTW
+static volatile uint8  eventos_ctw;
+static uint32 t_calibrar;
+static uint32 periodo_ms;
+static uint32 t_despertar;
+static uint64 activo_ms;
+static uint64 dormido_ms;
+static uint32 ciclos;
+static uint32 despertar_us;             //peor tiempo de reposicion despues del Sleep
+
+//El CTW queda como fuente de despertar con su interrupcion; la ISR solo limpia
+//el evento y marca el instante (lo usa la calibracion)
+CY_ISR(Ahorro_Ctw){
+    (void)CyPmReadStatus(CY_PM_CTW_INT);
+    t_ctw=Timebase_Now();
+    if(eventos_ctw<255u){
+        eventos_ctw++;
+    }
+}
+
+void Ahorro_Entrar(void){
+    if(estado!=AHORRO_APAGADO){
+        return;
+    }
+    activo_ms=0u;
+    dormido_ms=0u;
+    ciclos=0u;
+    despertar_us=0u;
+    eventos_ctw=0u;
+    (void)CyIntSetVector(AHORRO_CTW_IRQ,Ahorro_Ctw);
+    CyIntSetPriority(AHORRO_CTW_IRQ,7u);
+    CyPmCtwSetInterval(AHORRO_CTW_INTERVALO);
+    CY_PM_TW_CFG2_REG|=CY_PM_CTW_IE;
+    CyIntEnable(AHORRO_CTW_IRQ);
+    estado=AHORRO_CALIBRANDO;
+}
+
+//Vuelve al muestreo continuo con la tasa de la configuracion
+void Ahorro_Salir(void){
+    if(estado==AHORRO_APAGADO){
+        return;
+    }
+    CyIntDisable(AHORRO_CTW_IRQ);
+    CY_PM_TW_CFG2_REG&=(uint8)~CY_PM_CTW_IE;    //el CTW sigue: de el cuenta el watchdog
+    Adquisicion_SetDisparado(0u);
+    Adquisicion_SetRate(Config_Get()->muestreo_hz);
+    estado=AHORRO_APAGADO;
+}
+
+uint8 Ahorro_Estado(void){
+    return estado;
+}
+
+static void Dormir(void){
+    uint32 despierto,dormido,c0,c;
+
+    //el ultimo caracter termina de salir por la UART antes de apagar su reloj
+    CyDelayUs(CARACTER_US);
+    despierto=Timebase_Now()-t_ctw;
+    activo_ms+=despierto;
+    I2C_Sleep();
+    UART_Sleep();
+    Timer_1_Sleep();
+    CyPmSaveClocks();
+    CyPmSleep(PM_SLEEP_TIME_NONE,PM_SLEEP_SRC_CTW);
+    c0=DWT->CYCCNT;
+    CyPmRestoreClocks();
+    Timer_1_Wakeup();
+    UART_Wakeup();
+    I2C_Wakeup();
+    //ciclos a us con el reloj que este en uso (el gobernador puede tenerlo bajo)
+    c=(DWT->CYCCNT-c0)/cydelay_freq_mhz;
+    if(c>despertar_us){
+        despertar_us=c;
+    }
+    //el Timer_1 estuvo parado desde que se durmio hasta el evento del CTW
+    dormido=(despierto<periodo_ms) ? (periodo_ms-despierto) : 0u;
+    Timebase_Sumar(dormido);
+    dormido_ms+=dormido;
+    t_ctw=Timebase_Now();
+    t_despertar=t_ctw;
+    ciclos++;
+}
+
+//Desde Idle(): calibra el CTW y despues duerme cuando la muestra del ciclo ya se
+//proceso y las tareas tuvieron AHORRO_ACTIVO_MS para reportar. "puede_dormir" lo
+//decide el llamador (nada pendiente en la UART ni en la LCD). Mientras espera
+//detiene la CPU hasta la proxima interrupcion.
+void Ahorro_Poll(uint8 puede_dormir){
+    if(estado==AHORRO_APAGADO){
+        return;
+    }
+    if(estado==AHORRO_CALIBRANDO){
+        if(eventos_ctw==1u){
+            t_calibrar=t_ctw;
+        }else if(eventos_ctw>=2u){
+            periodo_ms=t_ctw-t_calibrar;
+            Adquisicion_SetDisparado(1u);
+            t_despertar=Timebase_Now();
+            estado=AHORRO_CICLANDO;
+            (void)Adquisicion_Disparar();
+        }
+        return;
+    }
+    if((puede_dormir!=0u) && Adquisicion_Libre() && (Ring_Crudo_Count(&cola_muestras)==0u) &&
+       Consola_Vacia() &&
+       ((Timebase_Now()-t_despertar)>=AHORRO_ACTIVO_MS)){
+        Dormir();
+        (void)Adquisicion_Disparar();
+        return;
+    }
+    __WFI();
+}
+
+//Fraccion del tiempo despierto, en por mil
+uint32 Ahorro_Ciclo_Permil(void){
+    uint64 total=activo_ms+dormido_ms;
+
+    return (total!=0u) ? (uint32)((activo_ms*1000u)/total) : 1000u;
+}
+
+//Peor tiempo desde que la CPU sale del Sleep hasta tener relojes y componentes
+//repuestos (no incluye el arranque del regulador, que no se puede medir aca)
+uint32 Ahorro_Despertar_us(void){
+    return despertar_us;
+}
+
+uint32 Ahorro_Periodo_ms(void){
+    return periodo_ms;
+}
+
+uint32 Ahorro_Ciclos(void){
+    return ciclos;
+}
+
+/* [] END OF FILE */
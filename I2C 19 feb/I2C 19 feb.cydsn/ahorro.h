@@ -0,0 +1,51 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef AHORRO_H
+#define AHORRO_H
+
+#include "project.h"
+
+//Modo de bajo consumo: una muestra por ciclo del CTW (timewheel central, ILO de
+//1 kHz) y el PSoC en Sleep el resto del tiempo. El INA219 pasa a modo disparado.
+//Mientras duerme no corren Timer_1 ni la UART: al despertar se adelanta la base
+//de tiempo con el periodo del CTW medido contra Timer_1 al entrar al modo (el
+//ILO tiene una tolerancia amplia). Lo que llega por la UART durante el Sleep se
+//pierde; para salir hay que mandar 'S' hasta ver "#AHORRO salir".
+//Ciclo de trabajo: por cada despertar corren la muestra, el cierre de la ventana
+//y el reporte, y no se vuelve a dormir hasta que la consola termina de mandar.
+//La linea de medicion ocupa ~20 bytes (solo potencia) a ~45 (los 4 canales), o
+//sea ~20..50 ms a 9600 baud, y el minimo es AHORRO_ACTIVO_MS: despierto ~40..50 ms
+//de cada 1024 (~4..5 %, ver "activo" en #AHORRO). Las lineas de diagnostico de
+//'r' se reducen a #AHORRO (~60 bytes, ~60 ms mas, solo cuando se piden).
+#define AHORRO_CTW_INTERVALO    0x0Au   //PM_TW_CFG1: 2^n ms, 0x0A = 1024 ms
+#define AHORRO_ACTIVO_MS        40u     //minimo despierto por ciclo: tareas y reporte
+#define AHORRO_CTW_IRQ          3u      //interrupcion de funcion fija del administrador de energia
+
+//Estados del modo
+enum
+{
+    AHORRO_APAGADO = 0u,
+    AHORRO_CALIBRANDO,      //midiendo el periodo del CTW con Timer_1
+    AHORRO_CICLANDO         //muestra, reporta y duerme hasta el proximo CTW
+};
+
+void   Ahorro_Entrar(void);
+void   Ahorro_Salir(void);
+uint8  Ahorro_Estado(void);
+void   Ahorro_Poll(uint8 puede_dormir);
+uint32 Ahorro_Ciclo_Permil(void);
+uint32 Ahorro_Despertar_us(void);
+uint32 Ahorro_Periodo_ms(void);
+uint32 Ahorro_Ciclos(void);
+
+#endif /* AHORRO_H */
+/* [] END OF FILE */
@@ -0,0 +1,164 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "alarma.h"
+#include "medicion.h"
+#include "timebase.h"
+#include "sched.h"
+#include "consola.h"
+#include <stdio.h>
+
+typedef struct
+{
+    int32 disparo;          //0 = alarma apagada
+    int32 libera;
+    uint8 cuenta;           //muestras seguidas del lado contrario al estado
+    uint8 activa;
+} Limite;
+
+static const char * const nombres[ALARMAS] = {"I", "V", "P"};
+static const char * const unidades[ALARMAS] = {"uA", "mV", "mW"};
+
+static Limite limites[ALARMAS];
+static uint8  rebote = 1u;
+static volatile uint8 activas;      //bit por alarma
+static uint8  tarea_aviso;
+static uint32 disparos;
+static uint32 latencia;             //us del ultimo disparo
+static uint32 peor_latencia;
+static Ring_Alarma cola_alarmas;
+
+void Alarma_Start(uint8 tarea){
+    tarea_aviso=tarea;
+    CyPins_ClearPin(ALARMA_PIN_PC);
+    CyPins_SetPinDriveMode(ALARMA_PIN_PC,PIN_DM_STRONG);
+}
+
+static void Limite_Init(Limite *l, int32 disparo, uint8 histeresis_pct){
+    l->disparo=disparo;
+    l->libera=(int32)(((int64)disparo*(100-(int32)histeresis_pct))/100);
+    l->cuenta=0u;
+    l->activa=0u;
+}
+
+//Limites en unidades de la configuracion (0 apaga la alarma). Reinicia el estado
+//de todas y baja el pin.
+void Alarma_Configurar(int32 ma, uint16 mv, int32 mw, uint8 histeresis_pct, uint8 reb){
+    uint8 s=CyEnterCriticalSection();
+
+    if(histeresis_pct>100u){
+        histeresis_pct=100u;
+    }
+    Limite_Init(&limites[ALARMA_I],ma*1000,histeresis_pct);
+    Limite_Init(&limites[ALARMA_V],(int32)mv,histeresis_pct);
+    Limite_Init(&limites[ALARMA_P],mw,histeresis_pct);
+    rebote=(reb!=0u) ? reb : 1u;
+    activas=0u;
+    CyPins_ClearPin(ALARMA_PIN_PC);
+    CyExitCriticalSection(s);
+}
+
+EN_RAM static void Avisar(uint8 tipo, uint8 activa, int32 valor, uint32 us){
+    Evento_Alarma e;
+
+    e.t_ms=Timebase_Now();
+    e.valor=valor;
+    e.latencia=us;
+    e.tipo=tipo;
+    e.activa=activa;
+    (void)Ring_Alarma_Push(&cola_alarmas,e);
+    Sched_Signal(tarea_aviso);
+}
+
+//Desde I2C_ISR con cada lectura completa. ciclo_lectura es el DWT CYCCNT a la
+//entrada de la interrupcion que trajo el dato.
+EN_RAM void Alarma_Evaluar(uint16 shunt_raw, uint16 bus_raw, uint32 ciclo_lectura){
+    Muestra m;
+    int32 v[ALARMAS];
+    uint8 k;
+
+    Medicion_Convertir(shunt_raw,bus_raw,0u,0u,&m);
+    v[ALARMA_I]=(m.corriente_ua<0) ? -m.corriente_ua : m.corriente_ua;
+    v[ALARMA_V]=(int32)m.vbus_mv;
+    v[ALARMA_P]=(m.potencia_mw<0) ? -m.potencia_mw : m.potencia_mw;
+    for(k=0;k<ALARMAS;k++){
+        Limite *l=&limites[k];
+
+        if(l->disparo==0){
+            continue;
+        }
+        if(l->activa==0u){
+            if(v[k]<l->disparo){
+                l->cuenta=0u;
+            }else if(++l->cuenta>=rebote){
+                uint32 us;
+
+                CyPins_SetPin(ALARMA_PIN_PC);
+                //a us con el reloj de este momento (el gobernador lo puede bajar)
+                us=(DWT->CYCCNT-ciclo_lectura)/cydelay_freq_mhz;
+                l->activa=1u;
+                l->cuenta=0u;
+                activas|=(uint8)(1u<<k);
+                disparos++;
+                latencia=us;
+                if(us>peor_latencia){
+                    peor_latencia=us;
+                }
+                Avisar(k,1u,v[k],us);
+            }
+        }else{
+            if(v[k]>l->libera){
+                l->cuenta=0u;
+            }else if(++l->cuenta>=rebote){
+                l->activa=0u;
+                l->cuenta=0u;
+                activas&=(uint8)~(1u<<k);
+                if(activas==0u){
+                    CyPins_ClearPin(ALARMA_PIN_PC);
+                }
+                Avisar(k,0u,v[k],0u);
+            }
+        }
+    }
+}
+
+//Tarea: una linea por cambio de estado, con la latencia del disparo en us. Lo que
+//no entra en la consola queda en la cola y sale en la proxima pasada
+void Alarma_Reportar(void){
+    Evento_Alarma e;
+
+    while((Consola_Libre()>=CONSOLA_LINEA) && Ring_Alarma_Pop(&cola_alarmas,&e)){
+        printf("#ALARMA %s=%u valor=%ld %s t=%lu latencia=%lu us\r\n",
+               nombres[e.tipo],e.activa,e.valor,unidades[e.tipo],e.t_ms,e.latencia);
+    }
+}
+
+uint8 Alarma_Pendientes(void){
+    return (Ring_Alarma_Count(&cola_alarmas)!=0u) ? 1u : 0u;
+}
+
+uint8 Alarma_Activas(void){
+    return activas;
+}
+
+uint32 Alarma_Disparos(void){
+    return disparos;
+}
+
+uint32 Alarma_Latencia_us(void){
+    return latencia;
+}
+
+uint32 Alarma_PeorLatencia_us(void){
+    return peor_latencia;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,64 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef ALARMA_H
+#define ALARMA_H
+
+#include "project.h"
+#include "ringbuf.h"
+#include "ramfunc.h"
+
+//Alarmas de sobrecorriente, sobretension y sobrepotencia evaluadas en I2C_ISR
+//con cada lectura completa, antes de encolar la muestra. Cada una tiene limite,
+//histeresis (se libera por debajo de limite*(100-h)/100) y rebote (muestras
+//seguidas para disparar o liberar). Mientras alguna esta activa la salida
+//ALARMA_PIN_PC queda en alto; el aviso por UART lo manda una tarea despues.
+//La latencia se mide con el DWT desde la entrada a I2C_ISR de la lectura que
+//dispara (el dato recien llegado al PSoC) hasta que el pin sube. El INA219 no
+//tiene salida de fin de conversion, asi que a esto hay que sumarle hasta un
+//periodo de muestreo mas la lectura I2C (~0.5 ms por registro a 100 kHz).
+
+//P2[1], el LED del kit CY8CKIT-059. No esta en TopDesign: se maneja por su
+//registro de control (modo y dato), sin componente Pins.
+#define ALARMA_PIN_PC       CYREG_PRT2_PC1
+
+enum
+{
+    ALARMA_I = 0u,      //corriente en uA (modulo)
+    ALARMA_V,           //tension del bus en mV
+    ALARMA_P,           //potencia en mW (modulo)
+    ALARMAS
+};
+
+//Cambio de estado de una alarma, de la ISR a la tarea que lo reporta
+typedef struct
+{
+    uint32 t_ms;
+    int32  valor;           //medicion que provoco el cambio
+    uint32 latencia;        //us hasta el pin (solo al disparar)
+    uint8  tipo;
+    uint8  activa;
+} Evento_Alarma;
+
+RING_DEFINIR(Ring_Alarma, Evento_Alarma, 8u)
+
+void   Alarma_Start(uint8 tarea);
+void   Alarma_Configurar(int32 ma, uint16 mv, int32 mw, uint8 histeresis_pct, uint8 rebote);
+EN_RAM void Alarma_Evaluar(uint16 shunt_raw, uint16 bus_raw, uint32 ciclo_lectura);
+void   Alarma_Reportar(void);
+uint8  Alarma_Pendientes(void);
+uint8  Alarma_Activas(void);
+uint32 Alarma_Disparos(void);
+uint32 Alarma_Latencia_us(void);
+uint32 Alarma_PeorLatencia_us(void);
+
+#endif /* ALARMA_H */
+/* [] END OF FILE */
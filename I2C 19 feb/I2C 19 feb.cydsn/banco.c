@@ -0,0 +1,90 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "banco.h"
+
+#if (PERFIL_HABILITADO != 0) && !defined(PERFIL_HOST)
+
+#include <stdio.h>
+#include "ramfunc.h"
+#include "medicion.h"
+
+#define BANCO_LATENCIAS     16u
+#define BANCO_MUESTRAS      64u
+
+volatile uint32 banco_entrada;
+
+//Pide isr_Rx por software y mide desde el pedido hasta la primera instruccion
+//de la ISR. Con la UART vacia la ISR solo sale, asi que no afecta los comandos.
+static void Medir_Latencia(uint32 *min, uint32 *max){
+    uint8 k;
+
+    *min=0xFFFFFFFFu;
+    *max=0u;
+    for(k=0;k<BANCO_LATENCIAS;k++){
+        uint32 t0,lat;
+
+        banco_entrada=0u;
+        t0=DWT->CYCCNT;
+        isr_Rx_SetPending();
+        __DSB();
+        __ISB();
+        lat=banco_entrada-t0;
+        if(banco_entrada==0u){
+            continue;
+        }
+        if(lat<*min){
+            *min=lat;
+        }
+        if(lat>*max){
+            *max=lat;
+        }
+    }
+}
+
+//Ciclos por muestra del camino de conversion (crudo -> ventana -> energia) con
+//las interrupciones apagadas para no contar ruido
+static uint32 Medir_Conversion(void){
+    Muestra m;
+    Ventana v={0};
+    Totales tot={0};
+    uint32 t0,total;
+    uint8 estado;
+    uint8 k;
+
+    estado=CyEnterCriticalSection();
+    t0=DWT->CYCCNT;
+    for(k=0;k<BANCO_MUESTRAS;k++){
+        Medicion_Convertir((uint16)(0x0100u+k),(uint16)(0x0600u+k),(uint32)k*20u,(uint32)k*20000u,&m);
+        Ventana_Agregar(&v,&m);
+        Totales_Integrar(&tot,&m);
+    }
+    total=DWT->CYCCNT-t0;
+    CyExitCriticalSection(estado);
+    return total/BANCO_MUESTRAS;
+}
+
+//Una linea: donde corre el camino caliente, estados de espera de la flash,
+//latencia min/max de isr_Rx y ciclos por muestra de la conversion
+void Banco_Ejecutar(void){
+    uint32 lat_min,lat_max,conv;
+
+    Medir_Latencia(&lat_min,&lat_max);
+    conv=Medir_Conversion();
+    printf("#BANCO %s %s bus=%uMHz ws=0x%02X lat=%lu..%lu conv=%lu\r\n",
+           EN_RAM_LUGAR,PERFIL_BUILD,(unsigned)BCLK__BUS_CLK__MHZ,
+           (unsigned)(CY_FLASH_CONTROL_REG & CY_FLASH_CACHE_WS_VALUE_MASK),
+           lat_min,lat_max,conv);
+}
+
+#endif
+
+/* [] END OF FILE */
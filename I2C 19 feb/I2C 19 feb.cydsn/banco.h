@@ -0,0 +1,37 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef BANCO_H
+#define BANCO_H
+
+#include "perfil.h"
+
+//Banco de pruebas de ejecucion desde flash vs SRAM: latencia de entrada a isr_Rx
+//y ciclos por muestra de la conversion. Usa el contador del DWT, asi que solo
+//existe cuando el perfilado esta habilitado.
+#if (PERFIL_HABILITADO != 0) && !defined(PERFIL_HOST)
+
+extern volatile uint32 banco_entrada;
+
+//Primera instruccion de la ISR medida
+#define Banco_Entrada()     (banco_entrada = DWT->CYCCNT)
+
+void Banco_Ejecutar(void);
+
+#else
+
+#define Banco_Entrada()     ((void)0)
+#define Banco_Ejecutar()    ((void)0)
+
+#endif
+
+#endif /* BANCO_H */
+/* [] END OF FILE */
@@ -0,0 +1,197 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "barrido.h"
+#include "adquisicion.h"
+#include "sensor.h"
+#include "timebase.h"
+#include "escala.h"
+#include <stdio.h>
+
+typedef struct
+{
+    int32  ref;             //primera muestra: las sumas van respecto de ella
+    int64  suma;
+    int64  suma2;
+} Estadistica;
+
+static uint8  activo;
+static uint8  paso;
+static uint16 config_base;
+static uint16 hz_base;
+static uint8  escala_base;
+static uint16 config_paso;
+static uint16 hz_paso;
+static uint32 conv_us;
+static uint32 ventana_ms;
+static uint32 t_paso;           //inicio del paso (para el limite sin muestras)
+static uint32 t_inicio;         //primera muestra de la ventana
+static uint32 errores_inicio;
+static uint32 ocupado_inicio;
+static uint8  descartar;
+static uint32 n;
+static Estadistica corriente;
+static Estadistica tension;
+
+static void Estadistica_Agregar(Estadistica *e, int32 v){
+    int32 d;
+
+    if(n==0u){
+        e->ref=v;
+        e->suma=0;
+        e->suma2=0;
+    }
+    d=v-e->ref;
+    e->suma+=d;
+    e->suma2+=(int64)d*d;
+}
+
+static uint32 Raiz(uint64 x){
+    uint64 r=0u,bit=(uint64)1u<<62;
+
+    while(bit>x){
+        bit>>=2;
+    }
+    while(bit!=0u){
+        if(x>=r+bit){
+            x-=r+bit;
+            r=(r>>1)+bit;
+        }else{
+            r>>=1;
+        }
+        bit>>=2;
+    }
+    return (uint32)r;
+}
+
+//Media y desvio estandar en decimas de la unidad de la muestra
+static int32 Media(const Estadistica *e){
+    return e->ref+(int32)(e->suma/(int64)n);
+}
+
+static uint32 Desvio_x10(const Estadistica *e){
+    int64 m10=(e->suma*10)/(int64)n;
+    int64 var100=((e->suma2*100)/(int64)n)-(m10*m10);
+
+    return (var100>0) ? Raiz((uint64)var100) : 0u;
+}
+
+static void Empezar_Paso(void){
+    uint32 ticks;
+
+    config_paso=Sensor_Config_Adc(config_base,paso);
+    conv_us=Sensor_Conversion_us(config_paso);
+    ticks=(conv_us+999u)/1000u;
+    if(ticks==0u){
+        ticks=1u;
+    }
+    hz_paso=(uint16)(TIMEBASE_TICK_HZ/ticks);
+    ventana_ms=BARRIDO_MIN_MUESTRAS*ticks;
+    if(ventana_ms<BARRIDO_VENTANA_MS){
+        ventana_ms=BARRIDO_VENTANA_MS;
+    }
+    n=0u;
+    descartar=BARRIDO_DESCARTE;
+    t_paso=Timebase_Now();
+    Adquisicion_SetConfig(config_paso);
+    Adquisicion_SetRate(hz_paso);
+}
+
+static void Terminar(void){
+    activo=0u;
+    Adquisicion_SetConfig(config_base);
+    Adquisicion_SetRate(hz_base);
+    Escala_Habilitar(escala_base);
+}
+
+void Barrido_Iniciar(uint16 ina_config, uint16 muestreo_hz){
+    config_base=ina_config;
+    hz_base=muestreo_hz;
+    escala_base=Escala_Habilitado();
+    Escala_Habilitar(0u);
+    paso=0u;
+    activo=1u;
+    printf("#ADC barrido sensor=%s pasos=%u ventana=%lu ms\r\n",SENSOR_NOMBRE,SENSOR_PASOS_ADC,(uint32)BARRIDO_VENTANA_MS);
+    Empezar_Paso();
+}
+
+void Barrido_Cancelar(void){
+    if(activo!=0u){
+        Terminar();
+        printf("#ADC cancelado\r\n");
+    }
+}
+
+uint8 Barrido_Activo(void){
+    return activo;
+}
+
+//Desde Procesar(), con cada muestra ya convertida
+void Barrido_Agregar(const Muestra *m, uint32 errores){
+    if((activo==0u) || (n>=BARRIDO_MAX_MUESTRAS)){
+        return;
+    }
+    if(descartar!=0u){
+        descartar--;
+        return;
+    }
+    if(n==0u){
+        t_inicio=Timebase_Now();
+        errores_inicio=errores;
+        ocupado_inicio=Adquisicion_Ocupado_us();
+    }
+    Estadistica_Agregar(&corriente,m->corriente_ua);
+    Estadistica_Agregar(&tension,(int32)m->vbus_mv);
+    n++;
+}
+
+//Tarea periodica: cierra la ventana del paso, reporta y pasa al siguiente
+void Barrido_Tarea(uint32 errores){
+    uint32 ahora=Timebase_Now();
+    uint32 dt,logrado_x10,i2c_permil,ruido_i,ruido_v;
+
+    if(activo==0u){
+        return;
+    }
+    if(n==0u){
+        if((ahora-t_paso)<(2u*ventana_ms)){
+            return;
+        }
+        //sin muestras (sensor desconectado o errores continuos)
+        printf("#ADC paso=%u config=0x%04X conv=%lu us n=0\r\n",paso,config_paso,conv_us);
+    }else{
+        dt=ahora-t_inicio;
+        if((dt<ventana_ms) && (n<BARRIDO_MAX_MUESTRAS)){
+            return;
+        }
+        if(dt==0u){
+            dt=1u;
+        }
+        logrado_x10=(n*10000u)/dt;
+        i2c_permil=(Adquisicion_Ocupado_us()-ocupado_inicio)/dt;
+        ruido_i=Desvio_x10(&corriente);
+        ruido_v=Desvio_x10(&tension)*100u;      //decimas de mV -> uV
+        printf("#ADC paso=%u config=0x%04X conv=%lu us hz=%u/%lu.%lu i2c=%lu.%lu%% err=%lu n=%lu"
+               " i=%ld uA ruido=%lu.%lu uA v=%ld mV ruido=%lu uV\r\n",
+               paso,config_paso,conv_us,hz_paso,logrado_x10/10u,logrado_x10%10u,
+               i2c_permil/10u,i2c_permil%10u,errores-errores_inicio,n,
+               Media(&corriente),ruido_i/10u,ruido_i%10u,Media(&tension),ruido_v);
+    }
+    paso++;
+    if(paso>=SENSOR_PASOS_ADC){
+        Terminar();
+        printf("#ADC fin\r\n");
+        return;
+    }
+    Empezar_Paso();
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,38 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef BARRIDO_H
+#define BARRIDO_H
+
+#include "project.h"
+#include "medicion.h"
+
+//Barrido de los tiempos de conversion y promedios del ADC del sensor ('A').
+//Para cada paso de Sensor_Config_Adc() pone la configuracion, muestrea al
+//periodo entero de ticks que alcanza a cubrir la conversion y, durante una
+//ventana con la carga fija, mide: muestras/s logradas, ocupacion del I2C
+//(tiempo con una muestra en curso), errores y solapes, y el piso de ruido
+//(desvio estandar de corriente y tension). Una linea "#ADC" por paso; al final
+//vuelve la configuracion y la tasa que habia. Mientras corre el gobernador del
+//reloj queda apagado, para que el tiempo medido no dependa de el.
+#define BARRIDO_VENTANA_MS      2000u
+#define BARRIDO_MIN_MUESTRAS    32u     //la ventana se alarga para juntar al menos estas
+#define BARRIDO_MAX_MUESTRAS    2048u   //y termina antes si llega a estas (sumas en int64)
+#define BARRIDO_DESCARTE        2u      //muestras tiradas despues de cambiar la configuracion
+
+void  Barrido_Iniciar(uint16 ina_config, uint16 muestreo_hz);
+void  Barrido_Cancelar(void);
+uint8 Barrido_Activo(void);
+void  Barrido_Agregar(const Muestra *m, uint32 errores);
+void  Barrido_Tarea(uint32 errores);
+
+#endif /* BARRIDO_H */
+/* [] END OF FILE */
@@ -0,0 +1,183 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "bateria.h"
+
+static const char * const sincros[] = {"apagada", "estimada", "lleno", "vacio", "manual"};
+
+static int64  capacidad;            //uA*ms; 0 = apagada
+static int64  restante;
+static int64  carga;
+static int64  descarga;
+static uint16 lleno_mv;
+static uint16 vacio_mv;
+static int32  cola_ua;
+static uint8  sincro;
+static uint32 t_sincro;
+static uint8  hay_anterior;
+static uint32 t_anterior;
+static int32  i_anterior;
+//condicion de resincronizacion en curso (BATERIA_LLENA o BATERIA_VACIA) y desde cuando
+static uint8  condicion;
+static uint32 t_condicion;
+//promedio para el tiempo restante
+static int64  q_segundo;
+static uint32 t_segundo;
+static int32  i_prom;
+static uint8  hay_prom;
+
+//Una capacidad distinta de la que esta en uso reinicia el estado (y el SoC se
+//vuelve a estimar con la proxima muestra); los umbrales se cambian sin perderlo
+void Bateria_Configurar(uint16 capacidad_mah, uint16 lleno, uint16 vacio, uint16 cola_ma){
+    int64 c=(int64)capacidad_mah*1000*BATERIA_UAMS_POR_UAH;
+
+    lleno_mv=lleno;
+    vacio_mv=vacio;
+    cola_ua=(int32)cola_ma*1000;
+    if(c==capacidad){
+        return;
+    }
+    capacidad=c;
+    restante=c;
+    sincro=(c!=0) ? BATERIA_ESTIMADA : BATERIA_APAGADA;
+    hay_anterior=0u;
+    condicion=0u;
+    hay_prom=0u;
+    i_prom=0;
+    q_segundo=0;
+}
+
+//Primera muestra: SoC por interpolacion lineal de la tension (llena si no hay umbrales)
+static void Estimar(uint16 mv){
+    if((lleno_mv>vacio_mv) && (vacio_mv!=0u)){
+        if(mv<=vacio_mv){
+            restante=0;
+        }else if(mv<lleno_mv){
+            restante=(capacidad*(int32)(mv-vacio_mv))/(int32)(lleno_mv-vacio_mv);
+        }else{
+            restante=capacidad;
+        }
+    }else{
+        restante=capacidad;
+    }
+    sincro=BATERIA_ESTIMADA;
+}
+
+EN_RAM void Bateria_Agregar(const Muestra *m){
+    int32 i=m->corriente_ua;
+    uint8 c=0u;
+    int64 q;
+
+    if(capacidad==0){
+        return;
+    }
+    if(hay_anterior==0u){
+        hay_anterior=1u;
+        t_anterior=m->t_ms;
+        t_segundo=m->t_ms;
+        i_anterior=i;
+        t_sincro=m->t_ms;
+        if(sincro==BATERIA_ESTIMADA){
+            Estimar(m->vbus_mv);
+        }
+        return;
+    }
+    q=((int64)(i_anterior+i)*(uint32)(m->t_ms-t_anterior))/2;
+    t_anterior=m->t_ms;
+    i_anterior=i;
+    if(q>=0){
+        descarga+=q;
+    }else{
+        carga-=q;
+    }
+    q_segundo+=q;
+    restante-=q;
+    if(restante<0){
+        restante=0;
+    }else if(restante>capacidad){
+        restante=capacidad;
+    }
+    //resincronizacion por tension, sostenida BATERIA_SINCRO_MS
+    if((lleno_mv!=0u) && (m->vbus_mv>=lleno_mv) &&
+       ((cola_ua==0) || ((i<cola_ua) && (i>-cola_ua)))){
+        c=BATERIA_LLENA;
+    }else if((vacio_mv!=0u) && (m->vbus_mv<=vacio_mv) && (i>0)){
+        c=BATERIA_VACIA;
+    }
+    if(c!=condicion){
+        condicion=c;
+        t_condicion=m->t_ms;
+    }else if((c!=0u) && ((uint32)(m->t_ms-t_condicion)>=BATERIA_SINCRO_MS)){
+        restante=(c==BATERIA_LLENA) ? capacidad : 0;
+        sincro=c;
+        t_sincro=m->t_ms;
+    }
+}
+
+//Cada segundo: corriente promedio del segundo (carga neta / tiempo) al IIR
+void Bateria_Segundo(void){
+    uint32 dt=t_anterior-t_segundo;
+    int32 i;
+
+    if((capacidad==0) || (dt==0u)){
+        return;
+    }
+    i=(int32)(q_segundo/(int32)dt);
+    q_segundo=0;
+    t_segundo=t_anterior;
+    if(hay_prom==0u){
+        hay_prom=1u;
+        i_prom=i;
+    }else{
+        i_prom+=(i-i_prom)>>BATERIA_PROMEDIO_K;
+    }
+}
+
+void Bateria_Llena(void){
+    restante=capacidad;
+    sincro=(capacidad!=0) ? BATERIA_MANUAL : BATERIA_APAGADA;
+    t_sincro=t_anterior;
+    condicion=0u;
+}
+
+//Pone en cero los contadores de carga y descarga (no toca la carga restante)
+void Bateria_Borrar(void){
+    carga=0;
+    descarga=0;
+}
+
+uint8 Bateria_Activa(void){
+    return (uint8)(capacidad!=0);
+}
+
+void Bateria_Leer(Bateria_Estado *e){
+    e->soc_permil=(uint16)((capacidad!=0) ? ((restante*1000)/capacidad) : 0);
+    e->restante_uah=(int32)(restante/BATERIA_UAMS_POR_UAH);
+    e->carga_uah=(int32)(carga/BATERIA_UAMS_POR_UAH);
+    e->descarga_uah=(int32)(descarga/BATERIA_UAMS_POR_UAH);
+    e->i_prom_ua=i_prom;
+    e->vacio_s=-1;
+    e->lleno_s=-1;
+    //uA*ms / uA = ms
+    if(i_prom>0){
+        e->vacio_s=(int32)((restante/i_prom)/1000);
+    }else if(i_prom<0){
+        e->lleno_s=(int32)(((capacidad-restante)/(-i_prom))/1000);
+    }
+    e->sincro=sincro;
+    e->sincro_s=(t_anterior-t_sincro)/1000u;
+}
+
+const char *Bateria_Sincro(uint8 s){
+    return (s<(sizeof(sincros)/sizeof(sincros[0]))) ? sincros[s] : "?";
+}
+
+/* [] END OF FILE */
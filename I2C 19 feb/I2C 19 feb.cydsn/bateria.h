@@ -0,0 +1,70 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef BATERIA_H
+#define BATERIA_H
+
+#include "project.h"
+#include "ramfunc.h"
+#include "medicion.h"
+
+//Monitor de bateria por conteo de carga (coulomb counting) sobre la corriente con
+//signo del registro del shunt. Con el shunt en serie con la bateria, corriente
+//positiva = descarga (la bateria alimenta la carga) y negativa = carga.
+//Con cada muestra se integra i*dt en uA*ms (trapecios, int64, sin punto flotante)
+//en dos contadores separados de carga y descarga y en la carga restante, que se
+//limita a 0..capacidad. El estado de carga (SoC) se resincroniza con la tension:
+// - lleno: Vbus >= "lleno" con |I| por debajo de la corriente de cola (fin de la
+//   carga) durante BATERIA_SINCRO_MS -> 100 %
+// - vacio: Vbus <= "vacio" descargando durante BATERIA_SINCRO_MS -> 0 %
+//Al arrancar (o al cambiar la capacidad) el SoC se estima interpolando la primera
+//tension entre vacio y lleno: es gruesa (tension bajo carga, no en vacio) y vale
+//hasta la primera resincronizacion. No se guarda en la flash.
+//El tiempo hasta vacio (o hasta lleno, cargando) sale de la carga restante y de
+//la corriente de 1 s promediada con un IIR de constante 2^BATERIA_PROMEDIO_K s.
+#define BATERIA_SINCRO_MS       10000u
+#define BATERIA_PROMEDIO_K      5u
+#define BATERIA_UAMS_POR_UAH    3600000LL
+
+//Origen del ultimo valor de la carga restante
+enum
+{
+    BATERIA_APAGADA = 0u,   //capacidad 0: modo bateria apagado
+    BATERIA_ESTIMADA,       //por tension al arrancar
+    BATERIA_LLENA,          //resincronizada en lleno
+    BATERIA_VACIA,          //resincronizada en vacio
+    BATERIA_MANUAL          //el usuario la marco como llena ('B')
+};
+
+typedef struct
+{
+    uint16 soc_permil;
+    int32  restante_uah;
+    int32  carga_uah;       //entrada a la bateria desde el ultimo borrado
+    int32  descarga_uah;    //salida de la bateria
+    int32  i_prom_ua;       //corriente promediada (positiva = descarga)
+    int32  vacio_s;         //tiempo hasta vacio, -1 si no esta descargando
+    int32  lleno_s;         //tiempo hasta lleno, -1 si no esta cargando
+    uint8  sincro;          //BATERIA_*
+    uint32 sincro_s;        //segundos desde la ultima resincronizacion
+} Bateria_Estado;
+
+void   Bateria_Configurar(uint16 capacidad_mah, uint16 lleno_mv, uint16 vacio_mv, uint16 cola_ma);
+EN_RAM void Bateria_Agregar(const Muestra *m);
+void   Bateria_Segundo(void);
+void   Bateria_Llena(void);
+void   Bateria_Borrar(void);
+uint8  Bateria_Activa(void);
+void   Bateria_Leer(Bateria_Estado *e);
+const char *Bateria_Sincro(uint8 sincro);
+
+#endif /* BATERIA_H */
+/* [] END OF FILE */
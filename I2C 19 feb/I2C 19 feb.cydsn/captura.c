@@ -0,0 +1,156 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "captura.h"
+#include "adquisicion.h"
+#include "sensor.h"
+#include "consola.h"
+#include <stdio.h>
+
+#define VOLCADO_TROZO       32u     //bytes maximos por llamada a Captura_Poll
+
+static int16  anillo[CAPTURA_N];
+static volatile uint8 estado = CAPTURA_APAGADA;
+static volatile uint8 forzar;
+static uint32 escritas;             //lecturas guardadas desde que se armo
+static uint32 disparo;              //indice absoluto de la muestra del disparo
+static uint32 faltan;               //muestras posteriores que faltan
+static uint32 pre = CAPTURA_N / 4u;
+static int32  umbral_ma = 500;
+static int16  umbral_crudo;
+static int16  anterior;
+static volatile uint32 perdidas;    //ticks sin lectura porque la anterior no termino
+static uint16 rshunt;
+
+//Volcado
+static uint32 volcar_desde;
+static uint32 volcar_n;
+static uint32 volcar_byte;
+
+//Desde la ISR del I2C (modo rapido): guarda y busca el flanco de disparo
+EN_RAM void Captura_Agregar(uint16 shunt){
+    int16 v=(int16)shunt;
+
+    if((estado!=CAPTURA_ARMADA) && (estado!=CAPTURA_DISPARADA)){
+        return;
+    }
+    anillo[escritas & (CAPTURA_N-1u)]=v;
+    escritas++;
+    if(estado==CAPTURA_ARMADA){
+        if((escritas>pre) &&
+           ((forzar!=0u) || ((anterior<umbral_crudo) && (v>=umbral_crudo)))){
+            disparo=escritas-1u;
+            faltan=CAPTURA_N-pre-1u;
+            estado=CAPTURA_DISPARADA;
+        }
+        anterior=v;
+        return;
+    }
+    if(--faltan==0u){
+        estado=CAPTURA_LISTA;
+    }
+}
+
+EN_RAM void Captura_Perdida(void){
+    perdidas++;
+}
+
+//Umbral en cuentas del registro del shunt
+static void Calcular_Umbral(void){
+    int32 crudo=Sensor_Shunt_Crudo(umbral_ma*1000,(int32)rshunt);
+
+    umbral_crudo=(int16)((crudo>32767) ? 32767 : ((crudo<-32768) ? -32768 : crudo));
+}
+
+void Captura_Armar(uint16 rshunt_mohm){
+    uint8 s=CyEnterCriticalSection();
+
+    rshunt=rshunt_mohm;
+    Calcular_Umbral();
+    escritas=0u;
+    perdidas=0u;
+    forzar=0u;
+    anterior=32767;     //el primer valor no puede ser un flanco
+    estado=CAPTURA_ARMADA;
+    CyExitCriticalSection(s);
+    Adquisicion_SetRapido(1u);
+}
+
+void Captura_Cancelar(void){
+    if(estado!=CAPTURA_APAGADA){
+        estado=CAPTURA_APAGADA;
+        Adquisicion_SetRapido(0u);
+    }
+}
+
+//Disparo manual: vale desde que hay "pre" muestras en el anillo
+void Captura_Disparar(void){
+    forzar=1u;
+}
+
+//Deja al menos una muestra posterior al disparo: con pre=CAPTURA_N-1 "faltan"
+//arrancaria en 0 y el decremento daria la vuelta
+void Captura_SetPre(uint32 muestras){
+    pre=(muestras<=(CAPTURA_N-2u)) ? muestras : (CAPTURA_N-2u);
+}
+
+uint32 Captura_Pre(void){
+    return pre;
+}
+
+void Captura_SetUmbral(int32 ma){
+    umbral_ma=ma;
+    Calcular_Umbral();
+}
+
+uint8 Captura_Estado(void){
+    return estado;
+}
+
+uint8 Captura_Volcando(void){
+    return (estado==CAPTURA_VOLCANDO) ? 1u : 0u;
+}
+
+//Desde Idle(): al congelarse vuelve al muestreo normal y vuelca sin bloquear
+void Captura_Poll(void){
+    uint8 k;
+
+    if(estado==CAPTURA_LISTA){
+        Adquisicion_SetRapido(0u);
+        volcar_n=(escritas<CAPTURA_N) ? escritas : CAPTURA_N;
+        volcar_desde=escritas-volcar_n;
+        volcar_byte=0u;
+        estado=CAPTURA_VOLCANDO;
+        printf("#CAPTURA n=%lu pre=%lu hz=%u disparo=%lu umbral=%ld mA sensor=%s rshunt=%u perdidas=%lu\r\n",
+               volcar_n,disparo-volcar_desde,CAPTURA_HZ,disparo,umbral_ma,SENSOR_NOMBRE,rshunt,perdidas);
+        return;
+    }
+    if(estado!=CAPTURA_VOLCANDO){
+        return;
+    }
+    for(k=0;k<VOLCADO_TROZO;k++){
+        const uint8 *p;
+
+        if(volcar_byte>=(volcar_n*2u)){
+            printf("#FIN\r\n");
+            estado=CAPTURA_APAGADA;
+            return;
+        }
+        if(Consola_Libre()==0u){
+            return;
+        }
+        p=(const uint8 *)&anillo[(volcar_desde+(volcar_byte>>1)) & (CAPTURA_N-1u)];
+        Consola_Byte(p[volcar_byte & 1u]);
+        volcar_byte++;
+    }
+}
+
+/* [] END OF FILE */
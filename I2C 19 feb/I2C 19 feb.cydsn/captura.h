@@ -0,0 +1,54 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef CAPTURA_H
+#define CAPTURA_H
+
+#include "project.h"
+#include "ramfunc.h"
+
+//Captura de formas de onda de corriente, como un osciloscopio de un canal.
+//Con la captura armada el sensor pasa a modo rapido (solo shunt, conversion
+//corta, una lectura por tick de 1 ms) y cada lectura cruda entra a un anillo de CAPTURA_N muestras
+//en SRAM. El disparo (flanco de subida de la corriente sobre el umbral, o 'T'
+//por la UART) congela el anillo despues de "post" muestras mas, y el contenido
+//sale en binario por la UART: "#CAPTURA ..." + n muestras int16 (registro del
+//shunt tal cual, escala de sensor.h segun "sensor=", little endian, de la mas
+//vieja a la mas nueva) + "#FIN".
+#define CAPTURA_N           8192u   //16 KB de SRAM
+#define CAPTURA_HZ          1000u   //una lectura por tick
+
+typedef char captura_n_potencia_de_2[((CAPTURA_N & (CAPTURA_N - 1u)) == 0u) ? 1 : -1];
+
+//Estados de la captura
+enum
+{
+    CAPTURA_APAGADA = 0u,
+    CAPTURA_ARMADA,         //llenando el anillo, esperando el disparo
+    CAPTURA_DISPARADA,      //juntando las muestras posteriores al disparo
+    CAPTURA_LISTA,          //congelada, falta volcarla
+    CAPTURA_VOLCANDO
+};
+
+void   Captura_Armar(uint16 rshunt_mohm);
+void   Captura_Cancelar(void);
+void   Captura_Disparar(void);
+void   Captura_SetPre(uint32 muestras);
+uint32 Captura_Pre(void);
+void   Captura_SetUmbral(int32 umbral_ma);
+uint8  Captura_Estado(void);
+uint8  Captura_Volcando(void);
+void   Captura_Poll(void);
+EN_RAM void Captura_Agregar(uint16 shunt);
+EN_RAM void Captura_Perdida(void);
+
+#endif /* CAPTURA_H */
+/* [] END OF FILE */
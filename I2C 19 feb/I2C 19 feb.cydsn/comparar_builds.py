@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+# Compara las configuraciones Debug y Release del firmware.
+#
+# Tamaños: cada configuracion deja, al terminar el build, la salida de
+#   arm-none-eabi-nm --size-sort -S -t d en CortexM3\ARM_GCC_541\<Config>\<proyecto>.nm.txt
+# Ciclos: el volcado del comando 'c' (lineas desde "#PERFIL") guardado desde la
+#   terminal serie. En Release hay que compilar con PERFIL_HABILITADO=1.
+#
+# Uso: comparar_builds.py debug.nm.txt release.nm.txt [debug_perfil.txt release_perfil.txt]
+
+import re
+import sys
+
+FLASH = set("TtRr")
+DATOS = set("Dd")
+RAM = set("BbDd")
+
+
+def leer_nm(ruta):
+    simbolos = {}
+    with open(ruta, encoding="utf-8", errors="replace") as f:
+        for linea in f:
+            campos = linea.split()
+            if len(campos) != 4:
+                continue
+            _, tam, tipo, nombre = campos
+            flash = int(tam) if (tipo in FLASH or tipo in DATOS) else 0
+            ram = int(tam) if tipo in RAM else 0
+            f_ant, r_ant = simbolos.get(nombre, (0, 0))
+            simbolos[nombre] = (f_ant + flash, r_ant + ram)
+    return simbolos
+
+
+def leer_perfil(ruta):
+    regiones = {}
+    patron = re.compile(r"^(\S+)\s+n=(\d+) min=(\d+) prom=(\d+) max=(\d+)")
+    with open(ruta, encoding="utf-8", errors="replace") as f:
+        for linea in f:
+            m = patron.match(linea.strip())
+            if m:
+                regiones[m.group(1)] = tuple(int(x) for x in m.group(2, 3, 4, 5))
+    return regiones
+
+
+def comparar_tamanos(debug, release):
+    print("%-32s %8s %8s %8s   %6s %6s %6s" %
+          ("funcion/dato", "flashD", "flashR", "delta", "ramD", "ramR", "delta"))
+    filas = []
+    for nombre in set(debug) | set(release):
+        fd, rd = debug.get(nombre, (0, 0))
+        fr, rr = release.get(nombre, (0, 0))
+        filas.append((nombre, fd, fr, rd, rr))
+    filas.sort(key=lambda x: abs(x[2] - x[1]) + abs(x[4] - x[3]), reverse=True)
+    for nombre, fd, fr, rd, rr in filas:
+        if fd == fr and rd == rr:
+            continue
+        print("%-32s %8d %8d %+8d   %6d %6d %+6d" %
+              (nombre[:32], fd, fr, fr - fd, rd, rr, rr - rd))
+    tfd = sum(x[1] for x in filas)
+    tfr = sum(x[2] for x in filas)
+    trd = sum(x[3] for x in filas)
+    trr = sum(x[4] for x in filas)
+    print("%-32s %8d %8d %+8d   %6d %6d %+6d" %
+          ("TOTAL", tfd, tfr, tfr - tfd, trd, trr, trr - trd))
+
+
+def comparar_ciclos(debug, release):
+    print()
+    print("%-10s %10s %10s %8s %10s %10s" %
+          ("region", "promD", "promR", "delta%", "maxD", "maxR"))
+    for region in debug:
+        if region not in release:
+            continue
+        pd = debug[region][2]
+        pr = release[region][2]
+        delta = (100.0 * (pr - pd) / pd) if pd else 0.0
+        print("%-10s %10d %10d %+7.1f%% %10d %10d" %
+              (region, pd, pr, delta, debug[region][3], release[region][3]))
+
+
+def main(args):
+    if len(args) not in (2, 4):
+        print("uso: comparar_builds.py debug.nm.txt release.nm.txt [debug_perfil.txt release_perfil.txt]")
+        return 1
+    comparar_tamanos(leer_nm(args[0]), leer_nm(args[1]))
+    if len(args) == 4:
+        comparar_ciclos(leer_perfil(args[2]), leer_perfil(args[3]))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,197 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "config.h"
+#include "adquisicion.h"
+#include "medicion.h"
+#include "timebase.h"
+#include "filtro.h"
+#include <string.h>
+#include <stddef.h>
+
+//La EEPROM emulada guarda bloques de media fila; el registro entra en uno solo
+#define CONFIG_BLOQUE       (CY_EM_EEPROM_EEPROM_DATA_LEN)
+#define CONFIG_DESGASTE     2u
+#define CONFIG_REDUNDANTE   1u
+#define CONFIG_FISICO       (CONFIG_BLOQUE * 2u * CONFIG_DESGASTE * (1u + CONFIG_REDUNDANTE))
+
+typedef char config_entra_en_bloque[(sizeof(Config) <= CONFIG_BLOQUE) ? 1 : -1];
+
+//Almacen en la flash de usuario, alineado a fila como pide cy_em_eeprom
+CY_ALIGN(CY_EM_EEPROM_FLASH_SIZEOF_ROW)
+static const uint8 almacen[CONFIG_FISICO] = {0u};
+
+static cy_stc_eeprom_context_t contexto;
+static Config activa;       //la que usa el firmware
+static Config editada;      //cambios en preparacion
+static Config guardada;     //copia de lo que hay en la EEPROM
+static uint8  hay_guardada;
+static uint32 escrituras;
+
+//CRC-16/CCITT (polinomio 0x1021, inicio 0xFFFF); Crc16_Seguir continua un CRC
+//parcial sobre otro tramo (lo usa registro.c para saltear el campo del CRC)
+uint16 Crc16_Seguir(uint16 crc, const uint8 *p, uint16 n){
+    uint8 b;
+
+    while(n-- != 0u){
+        crc^=(uint16)((uint16)*p++ << 8);
+        for(b=0;b<8u;b++){
+            crc=((crc & 0x8000u)!=0u) ? (uint16)((crc<<1)^0x1021u) : (uint16)(crc<<1);
+        }
+    }
+    return crc;
+}
+
+uint16 Crc16(const uint8 *p, uint16 n){
+    return Crc16_Seguir(0xFFFFu,p,n);
+}
+
+static uint16 Crc_Config(const Config *c){
+    return Crc16((const uint8 *)c,(uint16)offsetof(Config,crc));
+}
+
+void Config_Defecto(Config *c){
+    memset(c,0,sizeof(Config));
+    c->magia=CONFIG_MAGIA;
+    c->version=CONFIG_VERSION;
+    c->largo=(uint16)sizeof(Config);
+    c->rshunt_mohm=RSHUNT_MOHM;
+    c->ganancia_ppm=0;
+    c->offset_ua=0;
+    c->ina_config=SENSOR_CONFIG_DEFECTO;
+    c->muestreo_hz=50u;
+    c->uart_hz=1u;
+    c->lcd_hz=4u;
+    c->formato=FORMATO_P;
+    c->canales=CANAL_V | CANAL_I | CANAL_P;
+    c->alarma_mv=0u;
+    c->alarma_ma=0;
+    c->alarma_mw=0;
+    c->histeresis_pct=5u;
+    c->rebote=2u;
+    c->filtro_mediana=1u;
+    c->filtro_decima=1u;
+    c->filtro_orden=1u;
+    c->filtro_iir=0u;
+    c->bat_mah=0u;
+    c->bat_lleno_mv=0u;
+    c->bat_vacio_mv=0u;
+    c->bat_cola_ma=0u;
+    c->crc=Crc_Config(c);
+}
+
+//Una sola pasada: encabezado y CRC del bloque leido
+static uint8 Validar(const Config *c){
+    Filtro_Config f;
+
+    if((c->magia!=CONFIG_MAGIA) || (c->version!=CONFIG_VERSION) || (c->largo!=sizeof(Config))){
+        return 0u;
+    }
+    if((c->rshunt_mohm==0u) || (c->formato>=FORMATOS) || (c->histeresis_pct>100u) || (c->rebote==0u)){
+        return 0u;
+    }
+    if(Sensor_Config_Valida(c->ina_config)==0u){
+        return 0u;      //reset, modo apagado/disparado o bits reservados
+    }
+    if((c->bat_lleno_mv!=0u) && (c->bat_vacio_mv>=c->bat_lleno_mv)){
+        return 0u;
+    }
+    if((c->muestreo_hz==0u) || (c->uart_hz==0u) || (c->lcd_hz==0u) ||
+       (c->muestreo_hz>TIMEBASE_TICK_HZ) || (c->uart_hz>TIMEBASE_TICK_HZ) || (c->lcd_hz>TIMEBASE_TICK_HZ)){
+        return 0u;
+    }
+    f.mediana=c->filtro_mediana;
+    f.decimacion=c->filtro_decima;
+    f.orden=c->filtro_orden;
+    f.iir_k=c->filtro_iir;
+    if(Filtro_Valida(&f)==0u){
+        return 0u;
+    }
+    return (c->crc==Crc_Config(c)) ? 1u : 0u;
+}
+
+uint8 Config_Init(void){
+    cy_stc_eeprom_config_t cfg;
+    uint8 origen;
+
+    Config_Defecto(&activa);
+    cfg.eepromSize=CONFIG_BLOQUE;
+    cfg.wearLevelingFactor=CONFIG_DESGASTE;
+    cfg.redundantCopy=CONFIG_REDUNDANTE;
+    cfg.blockingWrite=1u;
+    cfg.userFlashStartAddr=(uint32)almacen;
+    hay_guardada=0u;
+    if(Cy_Em_EEPROM_Init(&cfg,&contexto)!=CY_EM_EEPROM_SUCCESS){
+        origen=CONFIG_ERROR;
+    }else if(Cy_Em_EEPROM_Read(0u,&guardada,sizeof(Config),&contexto)!=CY_EM_EEPROM_SUCCESS){
+        origen=CONFIG_ERROR;
+    }else if(guardada.magia!=CONFIG_MAGIA){
+        origen=CONFIG_VACIA;
+    }else if(Validar(&guardada)==0u){
+        origen=CONFIG_INVALIDA;
+    }else{
+        activa=guardada;
+        hay_guardada=1u;
+        origen=CONFIG_GUARDADA;
+    }
+    editada=activa;
+    return origen;
+}
+
+const Config *Config_Get(void){
+    return &activa;
+}
+
+//Los cambios se hacen sobre una copia; pasan a la EEPROM con Config_Guardar()
+Config *Config_Editar(void){
+    return &editada;
+}
+
+//1 si la copia editada difiere de lo que hay en la EEPROM
+uint8 Config_Pendiente(void){
+    editada.magia=CONFIG_MAGIA;
+    editada.version=CONFIG_VERSION;
+    editada.largo=(uint16)sizeof(Config);
+    editada.crc=Crc_Config(&editada);
+    if(hay_guardada==0u){
+        return 1u;
+    }
+    return (memcmp(&editada,&guardada,sizeof(Config))!=0) ? 1u : 0u;
+}
+
+//Valida la copia editada, la activa y la escribe solo si cambio. Bloquea mientras
+//se escribe la fila (decenas de ms), asi que se llama desde una tarea.
+cy_en_em_eeprom_status_t Config_Guardar(void){
+    cy_en_em_eeprom_status_t r;
+
+    if(Config_Pendiente()==0u){
+        activa=editada;
+        return CY_EM_EEPROM_SUCCESS;
+    }
+    if(Validar(&editada)==0u){
+        editada=activa;
+        return CY_EM_EEPROM_BAD_DATA;
+    }
+    activa=editada;
+    r=Cy_Em_EEPROM_Write(0u,&editada,sizeof(Config),&contexto);
+    if(r==CY_EM_EEPROM_SUCCESS){
+        guardada=editada;
+        hay_guardada=1u;
+        escrituras++;
+    }
+    return r;
+}
+
+uint32 Config_Escrituras(void){
+    return escrituras;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,92 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include "project.h"
+#include "cy_em_eeprom.h"
+#include "sensor.h"
+
+//Registro de configuracion persistente en la EEPROM emulada (flash de usuario).
+//Lleva magia, version y largo para reconocer registros de otro firmware, y un
+//CRC-16 sobre todo lo anterior. Si algo no coincide se arranca con los valores
+//por defecto y no se escribe nada hasta que el usuario guarde.
+#define CONFIG_MAGIA        0x5643u     //"VC"
+#define CONFIG_VERSION      (4u | ((uint16)SENSOR_MODELO << 8)) //2: limites de alarma, 3: filtros, 4: bateria
+//El byte alto de la version es el modelo de sensor: la configuracion guardada
+//con otro sensor (ina_config, rshunt) no se usa
+
+//Formato de la linea de medicion por UART
+enum
+{
+    FORMATO_P = 0u,         //"t<TAB>P" en W (el original)
+    FORMATO_CANALES,        //"t" seguido de los canales elegidos en el mapa
+    FORMATOS
+};
+
+//Mapa de canales (bits) para FORMATO_CANALES
+#define CANAL_V             0x01u
+#define CANAL_I             0x02u
+#define CANAL_P             0x04u
+#define CANAL_E             0x08u
+
+typedef struct
+{
+    uint16 magia;
+    uint16 version;
+    uint16 largo;           //sizeof(Config)
+    uint16 rshunt_mohm;     //resistencia shunt
+    int32  ganancia_ppm;    //correccion de ganancia de la corriente
+    int32  offset_ua;       //correccion de offset de la corriente
+    uint16 ina_config;      //registro de configuracion del sensor
+    uint16 muestreo_hz;
+    uint16 uart_hz;
+    uint16 lcd_hz;
+    uint8  formato;
+    uint8  canales;
+    uint16 alarma_mv;       //sobretension; 0 = apagada
+    int32  alarma_ma;       //sobrecorriente (modulo); 0 = apagada
+    int32  alarma_mw;       //sobrepotencia (modulo); 0 = apagada
+    uint8  histeresis_pct;  //las alarmas se liberan por debajo de limite*(100-h)/100
+    uint8  rebote;          //muestras seguidas para disparar o liberar una alarma
+    uint8  filtro_mediana;  //cadena de filtros de corriente y tension (filtro.h): N de la mediana
+    uint8  filtro_decima;   //R del CIC
+    uint8  filtro_orden;    //orden del CIC
+    uint8  filtro_iir;      //k del IIR
+    uint16 bat_mah;         //capacidad de la bateria (bateria.h); 0 = modo bateria apagado
+    uint16 bat_lleno_mv;    //tension de lleno para resincronizar; 0 = no resincroniza en lleno
+    uint16 bat_vacio_mv;    //tension de vacio; 0 = no resincroniza en vacio
+    uint16 bat_cola_ma;     //corriente de fin de carga; 0 = lleno solo por tension
+    uint16 crc;             //CRC-16/CCITT de todo lo anterior
+} Config;
+
+//Origen de la configuracion en uso
+enum
+{
+    CONFIG_GUARDADA = 0u,   //registro valido leido de la EEPROM
+    CONFIG_VACIA,           //EEPROM sin registro (primer arranque)
+    CONFIG_INVALIDA,        //magia, version, largo o CRC no coinciden
+    CONFIG_ERROR            //fallo la EEPROM emulada
+};
+
+uint8         Config_Init(void);
+const Config *Config_Get(void);
+Config       *Config_Editar(void);
+void          Config_Defecto(Config *c);
+uint8         Config_Pendiente(void);
+cy_en_em_eeprom_status_t Config_Guardar(void);
+uint32        Config_Escrituras(void);
+uint16        Crc16(const uint8 *p, uint16 n);
+uint16        Crc16_Seguir(uint16 crc, const uint8 *p, uint16 n);
+
+#endif /* CONFIG_H */
+/* [] END OF FILE */
@@ -0,0 +1,71 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "consola.h"
+
+static Ring_Tx cola_tx;
+static uint32  perdidos;        //bytes de texto descartados por cola llena
+
+//Productor: las tareas (un solo contexto, el del planificador). Un texto que no
+//entra completo no se manda, para no cortar lineas a la mitad.
+int Consola_Escribir(const char *p, int n){
+    int i;
+
+    if((n<=0) || ((uint32)n>Consola_Libre())){
+        perdidos+=(n>0) ? (uint32)n : 0u;
+        return n;
+    }
+    for(i=0;i<n;i++){
+        (void)Ring_Tx_Push(&cola_tx,p[i]);
+    }
+    return n;
+}
+
+uint32 Consola_Libre(void){
+    return CONSOLA_TX-Ring_Tx_Count(&cola_tx);
+}
+
+//Volcados binarios: el llamador ya verifico Consola_Libre()
+void Consola_Byte(uint8 b){
+    (void)Ring_Tx_Push(&cola_tx,(char)b);
+}
+
+//Nada en la cola ni en la FIFO de la UART (se puede dormir)
+uint8 Consola_Vacia(void){
+    return (uint8)((Ring_Tx_Count(&cola_tx)==0u) &&
+                   ((UART_ReadTxStatus() & UART_TX_STS_FIFO_EMPTY)!=0u));
+}
+
+uint32 Consola_Maximo(void){
+    return Ring_Tx_Maximo(&cola_tx);
+}
+
+void Consola_ResetMaximo(void){
+    (void)Ring_Tx_ResetMaximo(&cola_tx);
+}
+
+uint32 Consola_Perdidos(void){
+    return perdidos;
+}
+
+//Consumidor: ISR del tick. Llena la FIFO de TX con lo que haya en la cola.
+EN_RAM void Consola_Tick(void){
+    char c;
+
+    while((UART_ReadTxStatus() & UART_TX_STS_FIFO_NOT_FULL)!=0u){
+        if(Ring_Tx_Pop(&cola_tx,&c)==0u){
+            return;
+        }
+        UART_WriteTxData((uint8)c);
+    }
+}
+
+/* [] END OF FILE */
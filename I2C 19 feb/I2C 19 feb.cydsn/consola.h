@@ -0,0 +1,42 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef CONSOLA_H
+#define CONSOLA_H
+
+#include "project.h"
+#include "ringbuf.h"
+#include "ramfunc.h"
+
+//Salida por la UART sin esperas. La UART va a 9600 baud (~1 ms por caracter) con
+//una FIFO de 4 bytes y sin interrupcion de TX en el diseño, asi que escribir con
+//UART_PutChar dejaba a la tarea esperando ~1 ms por byte y el planificador
+//cooperativo sin poder vaciar cola_muestras. Ahora _write y los volcados binarios
+//solo encolan en cola_tx, y la ISR del tick de 1 ms (Consola_Tick) pasa a la
+//FIFO lo que entra: como sale menos de un caracter por tick, la FIFO no se vacia
+//mientras haya datos y se usa toda la velocidad de la linea (~960 B/s).
+//El texto que no entra en la cola se descarta entero y se cuenta (Consola_Perdidos).
+#define CONSOLA_TX          1024u   //~1 s de linea a 9600 baud
+#define CONSOLA_LINEA       96u     //lugar que piden los volcados de texto por linea
+
+RING_DEFINIR(Ring_Tx, char, CONSOLA_TX)
+
+int    Consola_Escribir(const char *p, int n);
+uint32 Consola_Libre(void);
+void   Consola_Byte(uint8 b);
+uint8  Consola_Vacia(void);
+uint32 Consola_Maximo(void);
+void   Consola_ResetMaximo(void);
+uint32 Consola_Perdidos(void);
+EN_RAM void Consola_Tick(void);
+
+#endif /* CONSOLA_H */
+/* [] END OF FILE */
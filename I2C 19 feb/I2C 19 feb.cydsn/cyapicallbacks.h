@@ -16,6 +16,16 @@
     /*Define your macro callbacks here */
     /*For more information, refer to the Writing Code topic in the PSoC Creator Help.*/
 
+    #include "ramfunc.h"
+
+    /* Entrada a cada interrupcion del I2C: marca el instante para la latencia de las alarmas */
+    #define I2C_ISR_ENTRY_CALLBACK
+    EN_RAM void I2C_ISR_EntryCallback(void);
+
+    /* Fin de cada interrupcion del I2C: avanza la adquisicion (adquisicion.c) */
+    #define I2C_ISR_EXIT_CALLBACK
+    EN_RAM void I2C_ISR_ExitCallback(void);
+
     
 #endif /* CYAPICALLBACKS_H */   
 /* [] */
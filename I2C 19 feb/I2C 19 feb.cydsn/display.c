@@ -0,0 +1,301 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "display.h"
+#include "perfil.h"
+#include <stdio.h>
+#include <string.h>
+
+//Glifos de la barra horizontal: el caracter n (1..5) tiene n columnas encendidas.
+//Se cargan en la CGRAM desde el caracter 1 (el 0 no se puede usar en cadenas C).
+#define GLIFO_PRIMERO   1u
+#define GLIFOS          5u
+#define NIVELES_CELDA   (GLIFOS)
+
+static const uint8 glifos[GLIFOS][LCD_CHARACTER_HEIGHT] =
+{
+    {0x10u,0x10u,0x10u,0x10u,0x10u,0x10u,0x10u,0x00u},
+    {0x18u,0x18u,0x18u,0x18u,0x18u,0x18u,0x18u,0x00u},
+    {0x1Cu,0x1Cu,0x1Cu,0x1Cu,0x1Cu,0x1Cu,0x1Cu,0x00u},
+    {0x1Eu,0x1Eu,0x1Eu,0x1Eu,0x1Eu,0x1Eu,0x1Eu,0x00u},
+    {0x1Fu,0x1Fu,0x1Fu,0x1Fu,0x1Fu,0x1Fu,0x1Fu,0x00u},
+};
+
+//Caracter a escribir segun cuantas columnas de la celda van encendidas
+static const char celda[NIVELES_CELDA + 1u] = {' ', 1, 2, 3, 4, 5};
+
+//Lo que hay en la LCD y lo que se quiere mostrar; solo se escriben las diferencias
+static char pantalla[DISPLAY_FILAS][DISPLAY_COLUMNAS];
+static char nuevo[DISPLAY_FILAS][DISPLAY_COLUMNAS];
+
+static volatile uint8 pagina = PAGINA_VIP;
+
+//Arranque de la LCD sin bloquear: la misma secuencia que LCD_Init() pero las
+//esperas del HD44780 se cuentan con la base de tiempo en vez de CyDelay, asi la
+//adquisicion y la UART arrancan primero y la LCD se completa en segundo plano.
+enum
+{
+    LCD_ENCENDIDO = 0u,     //40 ms desde el encendido
+    LCD_8BIT_1,
+    LCD_8BIT_2,
+    LCD_8BIT_3,
+    LCD_4BIT,
+    LCD_CONFIG,
+    LCD_LISTA
+};
+
+static uint8  arranque = LCD_ENCENDIDO;
+static uint32 espera_hasta;
+static uint32 t_inicio;
+static uint32 t_lista;
+
+static void Cargar_Glifos(void){
+    uint8 g,f;
+
+    LCD_WriteControl(LCD_CGRAM_0 | (GLIFO_PRIMERO * LCD_CHARACTER_HEIGHT));
+    for(g=0;g<GLIFOS;g++){
+        for(f=0;f<LCD_CHARACTER_HEIGHT;f++){
+            LCD_WriteData(glifos[g][f]);
+        }
+    }
+    LCD_Position(0u,0u);
+}
+
+//Medio byte de control, como LCD_WrCntrlNib() (que es privada del componente)
+static void Nibble_Control(uint8 nibble){
+    LCD_PORT_DR_REG &= ((uint8)(~(LCD_RS | LCD_RW)));
+    LCD_PORT_DR_REG &= ((uint8)(~LCD_DATA_MASK));
+#if(0u != LCD_PORT_SHIFT)
+    LCD_PORT_DR_REG |= (LCD_E | ((uint8)(nibble << LCD_PORT_SHIFT)));
+#else
+    LCD_PORT_DR_REG |= (LCD_E | nibble);
+#endif
+    CyDelayUs(1u);
+    LCD_PORT_DR_REG &= ((uint8)(~LCD_E));
+}
+
+static void Esperar(uint32 ms){
+    espera_hasta=Timebase_Now()+TIMEBASE_MS(ms);
+}
+
+//Solo arma el arranque; la LCD se inicializa llamando a Display_Poll()
+void Display_Start(void){
+    memset(pantalla,' ',sizeof(pantalla));
+    arranque=LCD_ENCENDIDO;
+    t_inicio=Timebase_Now();
+    Esperar(40u);
+}
+
+//Avanza un paso del arranque si ya paso la espera. Devuelve 1 solo en la
+//llamada en que la LCD queda lista.
+uint8 Display_Poll(void){
+    if(arranque==LCD_LISTA){
+        return 0u;
+    }
+    if((int32)(Timebase_Now()-espera_hasta)<0){
+        return 0u;
+    }
+    switch(arranque){
+        case LCD_ENCENDIDO:
+            Nibble_Control(LCD_DISPLAY_8_BIT_INIT);
+            Esperar(5u);
+            break;
+        case LCD_8BIT_1:
+            Nibble_Control(LCD_DISPLAY_8_BIT_INIT);
+            Esperar(15u);
+            break;
+        case LCD_8BIT_2:
+            Nibble_Control(LCD_DISPLAY_8_BIT_INIT);
+            Esperar(1u);
+            break;
+        case LCD_8BIT_3:
+            Nibble_Control(LCD_DISPLAY_4_BIT_INIT);
+            Esperar(5u);
+            break;
+        case LCD_4BIT:
+            //a partir de aca el controlador contesta el busy flag
+            LCD_WriteControl(LCD_CURSOR_AUTO_INCR_ON);
+            LCD_WriteControl(LCD_DISPLAY_2_LINES_5x10);
+            LCD_WriteControl(LCD_DISPLAY_ON_CURSOR_OFF);
+            LCD_WriteControl(LCD_CLEAR_DISPLAY);
+            Esperar(2u);
+            break;
+        default:
+            Cargar_Glifos();
+            LCD_initVar=1u;
+            LCD_enableState=1u;
+            t_lista=Timebase_Now();
+            break;
+    }
+    arranque++;
+    return (arranque==LCD_LISTA) ? 1u : 0u;
+}
+
+uint8 Display_Ready(void){
+    return (arranque==LCD_LISTA) ? 1u : 0u;
+}
+
+//ms desde Display_Start() hasta que la LCD quedo lista (0 si todavia no)
+uint32 Display_TiempoArranque(void){
+    return Display_Ready() ? (t_lista-t_inicio) : 0u;
+}
+
+void Display_SetPage(uint8 p){
+    if(p<PAGINAS){
+        pagina=p;
+    }
+}
+
+void Display_NextPage(void){
+    pagina=(uint8)((pagina+1u)%PAGINAS);
+}
+
+uint8 Display_GetPage(void){
+    return pagina;
+}
+
+//Copia el texto a la fila y completa con espacios; devuelve la columna siguiente
+static uint8 Fila(uint8 f, const char *txt){
+    uint8 c=0;
+
+    while((c<DISPLAY_COLUMNAS) && (txt[c]!='\0')){
+        nuevo[f][c]=txt[c];
+        c++;
+    }
+    memset(&nuevo[f][c],' ',DISPLAY_COLUMNAS-c);
+    return c;
+}
+
+//Barra de potencia desde la columna "desde" hasta el final de la fila
+static void Barra(uint8 f, uint8 desde, int32 valor, int32 escala){
+    uint8 celdas=(uint8)(DISPLAY_COLUMNAS-desde);
+    uint32 total=(uint32)celdas*NIVELES_CELDA;
+    uint32 nivel,c;
+
+    if(valor<=0){
+        nivel=0u;
+    }else if(valor>=escala){
+        nivel=total;
+    }else{
+        nivel=((uint32)valor*total)/(uint32)escala;
+    }
+    for(c=0;c<celdas;c++){
+        uint32 n=(nivel>=NIVELES_CELDA) ? NIVELES_CELDA : nivel;
+        nuevo[f][desde+c]=celda[n];
+        nivel-=n;
+    }
+}
+
+static void Pagina_VIP(const Display_Datos *d){
+    char txt[DISPLAY_COLUMNAS+8];
+    uint8 n;
+
+    n=Medicion_Formato(txt,d->resumen.vbus_mv,2u);
+    txt[n++]='V';
+    txt[n++]=' ';
+    n+=Medicion_Formato(&txt[n],d->resumen.corriente_ua/1000,3u);
+    txt[n++]='A';
+    txt[n]='\0';
+    (void)Fila(0u,txt);
+
+    n=Medicion_Formato(txt,d->resumen.potencia_mw,2u);
+    txt[n++]='W';
+    txt[n]='\0';
+    n=Fila(1u,txt);
+    if(n<DISPLAY_COLUMNAS-1u){
+        Barra(1u,(uint8)(n+1u),d->resumen.potencia_mw,DISPLAY_PMAX_MW);
+    }
+}
+
+static void Pagina_Energia(const Display_Datos *d){
+    char txt[DISPLAY_COLUMNAS+8];
+    uint8 n;
+
+    txt[0]='E';
+    txt[1]=' ';
+    n=(uint8)(2u+Medicion_Formato(&txt[2],d->energia_mwh,3u));
+    txt[n++]='W';
+    txt[n++]='h';
+    txt[n]='\0';
+    (void)Fila(0u,txt);
+
+    sprintf(txt,"T %02lu:%02lu:%02lu",(unsigned long)(d->segundos/3600u),
+            (unsigned long)((d->segundos/60u)%60u),(unsigned long)(d->segundos%60u));
+    (void)Fila(1u,txt);
+}
+
+static void Pagina_MinMax(const Display_Datos *d){
+    char txt[DISPLAY_COLUMNAS+8];
+    uint8 n;
+
+    strcpy(txt,"Pmin ");
+    n=(uint8)(5u+Medicion_Formato(&txt[5],d->resumen.pmin_mw,2u));
+    txt[n++]='W';
+    txt[n]='\0';
+    (void)Fila(0u,txt);
+
+    strcpy(txt,"Pmax ");
+    n=(uint8)(5u+Medicion_Formato(&txt[5],d->resumen.pmax_mw,2u));
+    txt[n++]='W';
+    txt[n]='\0';
+    (void)Fila(1u,txt);
+}
+
+static void Pagina_Errores(const Display_Datos *d){
+    char txt[DISPLAY_COLUMNAS+8];
+
+    sprintf(txt,"I2C err %lu",(unsigned long)d->err_i2c);
+    (void)Fila(0u,txt);
+    sprintf(txt,"Perdidas %lu",(unsigned long)d->perdidas);
+    (void)Fila(1u,txt);
+}
+
+//Arma la pagina actual y escribe en la LCD solo los caracteres que cambiaron
+void Display_Refresh(const Display_Datos *d){
+    uint8 f,c;
+    uint8 cursor_f=0xFFu,cursor_c=0xFFu;
+
+    switch(pagina){
+        case PAGINA_ENERGIA:
+            Pagina_Energia(d);
+            break;
+        case PAGINA_MINMAX:
+            Pagina_MinMax(d);
+            break;
+        case PAGINA_ERRORES:
+            Pagina_Errores(d);
+            break;
+        default:
+            Pagina_VIP(d);
+            break;
+    }
+
+    if(arranque!=LCD_LISTA){
+        return;
+    }
+    PERFIL_INICIO(PF_LCD);
+    for(f=0;f<DISPLAY_FILAS;f++){
+        for(c=0;c<DISPLAY_COLUMNAS;c++){
+            if(nuevo[f][c]!=pantalla[f][c]){
+                if((f!=cursor_f) || (c!=cursor_c)){
+                    LCD_Position(f,c);
+                }
+                LCD_PutChar(nuevo[f][c]);
+                pantalla[f][c]=nuevo[f][c];
+                cursor_f=f;
+                cursor_c=(uint8)(c+1u);
+            }
+        }
+    }
+    PERFIL_FIN(PF_LCD);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,55 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include "project.h"
+#include "medicion.h"
+#include "timebase.h"
+
+#define DISPLAY_FILAS       2u
+#define DISPLAY_COLUMNAS    16u
+
+//Escala completa de la barra de potencia (75 W de la especificacion)
+#define DISPLAY_PMAX_MW     75000
+
+//Paginas de la LCD; se cambian con un comando UART
+enum
+{
+    PAGINA_VIP = 0u,        //V, I, P y barra de potencia
+    PAGINA_ENERGIA,         //energia acumulada y tiempo de funcionamiento
+    PAGINA_MINMAX,          //potencia minima y maxima de la ultima ventana
+    PAGINA_ERRORES,         //contadores de error
+    PAGINAS
+};
+
+//Lo que muestra la LCD; lo arma main.c antes de cada refresco
+typedef struct
+{
+    Resumen resumen;
+    int32   energia_mwh;
+    uint32  segundos;
+    uint32  err_i2c;
+    uint32  perdidas;
+} Display_Datos;
+
+void  Display_Start(void);
+uint8 Display_Poll(void);
+uint8 Display_Ready(void);
+uint32 Display_TiempoArranque(void);
+void  Display_SetPage(uint8 pagina);
+void  Display_NextPage(void);
+uint8 Display_GetPage(void);
+void  Display_Refresh(const Display_Datos *d);
+
+#endif /* DISPLAY_H */
+/* [] END OF FILE */
@@ -0,0 +1,85 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "eficiencia.h"
+
+static int64  suma_in;              //uW
+static int64  suma_out;
+static uint32 n;
+static uint32 n_inst;               //pares con potencia de entrada
+static int32  inst;
+static int32  inst_min;
+static int32  inst_max;
+static uint32 suma_sesgo;
+static uint32 sesgo_min;
+static uint32 sesgo_max;
+
+void Eficiencia_Reiniciar(void){
+    suma_in=0;
+    suma_out=0;
+    n=0u;
+    n_inst=0u;
+    inst=-1;
+    suma_sesgo=0u;
+    sesgo_min=0u;
+    sesgo_max=0u;
+}
+
+static int64 Potencia_uw(const Muestra *m){
+    return ((int64)m->corriente_ua*m->vbus_mv)/1000;
+}
+
+void Eficiencia_Agregar(const Muestra *entrada, const Muestra *salida, uint16 sesgo_us){
+    int64 pin=Potencia_uw(entrada);
+    int64 pout=Potencia_uw(salida);
+
+    suma_in+=pin;
+    suma_out+=pout;
+    if(pin>0){
+        inst=(int32)((pout*1000)/pin);
+        if((n_inst==0u) || (inst<inst_min)){
+            inst_min=inst;
+        }
+        if((n_inst==0u) || (inst>inst_max)){
+            inst_max=inst;
+        }
+        n_inst++;
+    }
+    if((n==0u) || (sesgo_us<sesgo_min)){
+        sesgo_min=sesgo_us;
+    }
+    if(sesgo_us>sesgo_max){
+        sesgo_max=sesgo_us;
+    }
+    suma_sesgo+=sesgo_us;
+    n++;
+}
+
+//Entrega la ventana y empieza otra (la instantanea se conserva)
+void Eficiencia_Cerrar(Eficiencia_Resumen *r){
+    int32 ultima=inst;
+
+    r->n=n;
+    r->ef_permil=(suma_in>0) ? (int32)((suma_out*1000)/suma_in) : -1;
+    r->inst_permil=inst;
+    r->inst_min=(n_inst!=0u) ? inst_min : -1;
+    r->inst_max=(n_inst!=0u) ? inst_max : -1;
+    r->pin_mw=(n!=0u) ? (int32)((suma_in/n)/1000) : 0;
+    r->pout_mw=(n!=0u) ? (int32)((suma_out/n)/1000) : 0;
+    r->perdida_mw=(n!=0u) ? (int32)(((suma_in-suma_out)/n)/1000) : 0;
+    r->sesgo_min_us=sesgo_min;
+    r->sesgo_prom_us=(n!=0u) ? (suma_sesgo/n) : 0u;
+    r->sesgo_max_us=sesgo_max;
+    Eficiencia_Reiniciar();
+    inst=ultima;
+}
+
+/* [] END OF FILE */
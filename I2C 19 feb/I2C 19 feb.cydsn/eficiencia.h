@@ -0,0 +1,45 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef EFICIENCIA_H
+#define EFICIENCIA_H
+
+#include "project.h"
+#include "medicion.h"
+
+//Eficiencia de un convertidor DC-DC con un sensor a la entrada y otro a la salida
+//(modo dual de adquisicion.c). Con cada par se calcula la eficiencia instantanea
+//Pout/Pin y la potencia perdida Pin-Pout, en uW a partir de uA y mV para no
+//perder resolucion con cargas chicas. La eficiencia de la ventana es el cociente
+//de las sumas (los pares estan equiespaciados, asi que es el de las energias).
+//Los dos sensores usan la misma calibracion del shunt (Medicion_Calibrar).
+
+typedef struct
+{
+    uint32 n;               //pares de la ventana
+    int32  ef_permil;       //eficiencia de la ventana; -1 sin potencia de entrada
+    int32  inst_permil;     //ultimo par
+    int32  inst_min;        //rango de la eficiencia instantanea en la ventana
+    int32  inst_max;
+    int32  pin_mw;          //promedios de la ventana
+    int32  pout_mw;
+    int32  perdida_mw;
+    uint32 sesgo_min_us;    //sesgo entre los disparos de los dos sensores
+    uint32 sesgo_prom_us;
+    uint32 sesgo_max_us;
+} Eficiencia_Resumen;
+
+void Eficiencia_Reiniciar(void);
+void Eficiencia_Agregar(const Muestra *entrada, const Muestra *salida, uint16 sesgo_us);
+void Eficiencia_Cerrar(Eficiencia_Resumen *r);
+
+#endif /* EFICIENCIA_H */
+/* [] END OF FILE */
@@ -0,0 +1,141 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "escala.h"
+#include "adquisicion.h"
+#include "timebase.h"
+
+#define BUS_MHZ             (BCLK__BUS_CLK__HZ / 1000000u)
+
+typedef char escala_divide_i2c[(((I2C_DEFAULT_DIVIDE_FACTOR + 1u) % ESCALA_DIVISOR) == 0u) ? 1 : -1];
+
+static uint8  habilitado;
+static uint8  baja;
+static uint32 t_cambio;        //Timebase_Us() del ultimo cambio o cuenta
+static uint64 us_alta;
+static uint64 us_baja;
+static uint32 cambios;
+
+//Acumula el tramo desde el ultimo cambio en el reloj que estuvo activo. Va en us
+//(Timer_1 sale del reloj maestro y no cambia con el bus): entre Idle y la
+//proxima tarea el bus cambia varias veces dentro de un mismo tick de 1 ms
+static void Contar(uint32 ahora){
+    if(baja!=0u){
+        us_baja+=ahora-t_cambio;
+    }else{
+        us_alta+=ahora-t_cambio;
+    }
+    t_cambio=ahora;
+}
+
+static void Divisor_I2C(uint16 factor){
+    I2C_CLKDIV1_REG=LO8(factor);
+    I2C_CLKDIV2_REG=HI8(factor);
+}
+
+//Cambia el bus con las interrupciones apagadas y solo si no hay una transferencia
+//I2C en el bus (si la hay se deja para la proxima oportunidad). La espera de la
+//conversion en modo disparado o eficiencia no bloquea: dura varios ticks y el
+//proximo paso lo arranca el tick, que no corre mientras se cambia.
+static void Cambiar(uint8 a_baja){
+    uint8 estado;
+
+    if(baja==a_baja){
+        return;
+    }
+    estado=CyEnterCriticalSection();
+    if(Adquisicion_Transfiriendo()==0u){
+        Contar(Timebase_Us());
+        if(a_baja!=0u){
+            CyBusClk_SetDivider((uint16)(ESCALA_DIVISOR-1u));
+            Divisor_I2C((uint16)(((I2C_DEFAULT_DIVIDE_FACTOR+1u)/ESCALA_DIVISOR)-1u));
+            CyFlash_SetWaitCycles((uint8)(BUS_MHZ/ESCALA_DIVISOR));
+            CyDelayFreq(BCLK__BUS_CLK__HZ/ESCALA_DIVISOR);
+        }else{
+            CyFlash_SetWaitCycles((uint8)BUS_MHZ);
+            CyBusClk_SetDivider(0u);
+            Divisor_I2C(I2C_DEFAULT_DIVIDE_FACTOR);
+            CyDelayFreq(BCLK__BUS_CLK__HZ);
+        }
+        baja=a_baja;
+        cambios++;
+    }
+    CyExitCriticalSection(estado);
+}
+
+void Escala_Start(void){
+    habilitado=0u;
+    baja=0u;
+    Escala_Reset();
+}
+
+//Antes de cada tarea (Sched_SetDespacho)
+void Escala_Alta(void){
+    Cambiar(0u);
+}
+
+//Desde Idle(): nada listo, se espera a una interrupcion con el bus bajo
+void Escala_Baja(void){
+    if(habilitado!=0u){
+        Cambiar(1u);
+    }
+}
+
+void Escala_Habilitar(uint8 on){
+    habilitado=on;
+    if(on==0u){
+        Cambiar(0u);
+    }
+}
+
+uint8 Escala_Habilitado(void){
+    return habilitado;
+}
+
+uint32 Escala_Cambios(void){
+    return cambios;
+}
+
+//Reloj de bus promedio desde el ultimo Escala_Reset
+uint32 Escala_Promedio_kHz(void){
+    uint64 total;
+
+    Contar(Timebase_Us());
+    total=us_alta+us_baja;
+    if(total==0u){
+        return BCLK__BUS_CLK__HZ/1000u;
+    }
+    return (uint32)(((us_alta*BCLK__BUS_CLK__HZ)+(us_baja*(BCLK__BUS_CLK__HZ/ESCALA_DIVISOR)))/
+                    (total*1000u));
+}
+
+//Energia estimada del nucleo por muestra (modelo de arriba, Vddd del diseño)
+uint32 Escala_Energia_uJ(uint32 muestras){
+    uint64 i_ua_us;
+
+    Contar(Timebase_Us());
+    if(muestras==0u){
+        return 0u;
+    }
+    i_ua_us=(us_alta*(ESCALA_I0_UA+(ESCALA_K_UA_MHZ*BUS_MHZ)))+
+            (us_baja*(ESCALA_I0_UA+((ESCALA_K_UA_MHZ*BUS_MHZ)/ESCALA_DIVISOR)));
+    //uA*us*mV = 1e-15 J -> /1e9 para uJ
+    return (uint32)((i_ua_us*CYDEV_VDDD_MV)/((uint64)muestras*1000000000u));
+}
+
+void Escala_Reset(void){
+    t_cambio=Timebase_Us();
+    us_alta=0u;
+    us_baja=0u;
+    cambios=0u;
+}
+
+/* [] END OF FILE */
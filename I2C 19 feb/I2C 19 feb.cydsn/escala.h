@@ -0,0 +1,41 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef ESCALA_H
+#define ESCALA_H
+
+#include "project.h"
+
+//Gobernador del reloj de bus (CPU y perifericos de funcion fija): baja a
+//BCLK/ESCALA_DIVISOR cuando no hay tareas listas y vuelve a BCLK antes de cada
+//tarea. Solo se divide el bus: los relojes digitales de la UART y de Timer_1
+//salen del reloj maestro y no cambian; el divisor del I2C de funcion fija, que
+//sale del bus, se ajusta en la misma proporcion. El cambio se hace con el I2C
+//libre y actualiza CyDelay y los ciclos de espera de la flash.
+#define ESCALA_DIVISOR      4u      //24 MHz -> 6 MHz (potencia de 2, divide exacto al I2C)
+
+//Modelo de consumo del nucleo para estimar energia: I = I0 + k*f (hoja de datos
+//del CY8C58LP, modo activo, tipico). No es una medicion.
+#define ESCALA_I0_UA        1200u
+#define ESCALA_K_UA_MHZ     210u
+
+void   Escala_Start(void);
+void   Escala_Alta(void);
+void   Escala_Baja(void);
+void   Escala_Habilitar(uint8 on);
+uint8  Escala_Habilitado(void);
+uint32 Escala_Cambios(void);
+uint32 Escala_Promedio_kHz(void);
+uint32 Escala_Energia_uJ(uint32 muestras);
+void   Escala_Reset(void);
+
+#endif /* ESCALA_H */
+/* [] END OF FILE */
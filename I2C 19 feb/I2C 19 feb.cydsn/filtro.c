@@ -0,0 +1,134 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "filtro.h"
+
+uint8 Filtro_Valida(const Filtro_Config *c){
+    if((c->mediana==0u) || (c->mediana>FILTRO_MEDIANA_MAX) || ((c->mediana & 1u)==0u)){
+        return 0u;
+    }
+    if((c->decimacion==0u) || (c->decimacion>FILTRO_DECIMA_MAX)){
+        return 0u;
+    }
+    if((c->orden==0u) || (c->orden>FILTRO_ORDEN_MAX) || (c->iir_k>FILTRO_IIR_MAX)){
+        return 0u;
+    }
+    return 1u;
+}
+
+void Filtro_Iniciar(Filtro *f, const Filtro_Config *c){
+    uint8 k;
+
+    f->cfg=*c;
+    f->n_ventana=0u;
+    f->pos=0u;
+    for(k=0;k<FILTRO_ORDEN_MAX;k++){
+        f->integ[k]=0u;
+        f->peine[k]=0u;
+    }
+    f->fase=0u;
+    f->descartar=(uint8)(c->orden-1u);
+    f->hay_iir=0u;
+    f->iir=0;
+}
+
+//Mediana de las ultimas N entradas (menos mientras se llena la ventana)
+int32 Filtro_Mediana(Filtro *f, int32 x){
+    int32 orden[FILTRO_MEDIANA_MAX];
+    uint8 n,i,j;
+
+    if(f->cfg.mediana<=1u){
+        return x;
+    }
+    f->ventana[f->pos]=x;
+    if(++f->pos>=f->cfg.mediana){
+        f->pos=0u;
+    }
+    if(f->n_ventana<f->cfg.mediana){
+        f->n_ventana++;
+    }
+    n=f->n_ventana;
+    for(i=0;i<n;i++){
+        int32 v=f->ventana[i];
+
+        for(j=i;(j>0u) && (orden[j-1u]>v);j--){
+            orden[j]=orden[j-1u];
+        }
+        orden[j]=v;
+    }
+    return orden[n/2u];
+}
+
+//CIC: integradores a la tasa de entrada, peines a la de salida. Devuelve 1 y la
+//salida (ya dividida por la ganancia R^orden, redondeada) cada R entradas.
+uint8 Filtro_Cic(Filtro *f, int32 x, int32 *y){
+    uint64 v=(uint64)(int64)x;
+    uint64 g;
+    uint8 k;
+
+    for(k=0;k<f->cfg.orden;k++){
+        f->integ[k]+=v;
+        v=f->integ[k];
+    }
+    if(++f->fase<f->cfg.decimacion){
+        return 0u;
+    }
+    f->fase=0u;
+    for(k=0;k<f->cfg.orden;k++){
+        uint64 ant=f->peine[k];
+
+        f->peine[k]=v;
+        v-=ant;
+    }
+    if(f->descartar!=0u){
+        f->descartar--;     //los peines todavia no tienen una salida anterior valida
+        return 0u;
+    }
+    g=f->cfg.decimacion;
+    if(f->cfg.orden>1u){
+        g*=f->cfg.decimacion;
+    }
+    {
+        int64 s=(int64)v;
+
+        *y=(int32)((s>=0) ? ((s+(int64)(g/2u))/(int64)g) : ((s-(int64)(g/2u))/(int64)g));
+    }
+    return 1u;
+}
+
+//IIR de primer orden; arranca en el primer valor para no subir desde cero
+int32 Filtro_Iir(Filtro *f, int32 x){
+    int64 xq=(int64)x*(1<<FILTRO_IIR_FRAC);
+
+    if(f->cfg.iir_k==0u){
+        return x;
+    }
+    if(f->hay_iir==0u){
+        f->hay_iir=1u;
+        f->iir=xq;
+    }else{
+        f->iir+=(xq-f->iir)>>f->cfg.iir_k;
+    }
+    return (int32)((f->iir+(1<<(FILTRO_IIR_FRAC-1u)))>>FILTRO_IIR_FRAC);
+}
+
+//Una entrada por la cadena completa; devuelve 1 cuando sale un valor decimado
+uint8 Filtro_Agregar(Filtro *f, int32 x, int32 *y){
+    int32 d;
+
+    if(Filtro_Cic(f,Filtro_Mediana(f,x),&d)==0u){
+        return 0u;
+    }
+    *y=Filtro_Iir(f,d);
+    return 1u;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,72 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef FILTRO_H
+#define FILTRO_H
+
+//Cadena de filtros enteros por canal, a la tasa de muestreo:
+//  mediana de N (quita picos aislados) -> CIC de orden 1 o 2 que decima por R
+//  (orden 1 = promedio de a bloques) -> IIR de primer orden y += (x - y) / 2^k
+//Con N=1, R=1 y k=0 la salida es la entrada. El CIC integra en aritmetica
+//modular de 64 bits, asi que los integradores pueden dar la vuelta sin error
+//mientras la salida entre en el rango. El IIR guarda 8 bits de fraccion para no
+//quedarse trabado a menos de 2^k cuentas del valor final.
+//No depende del PSoC: compilando con -DFILTRO_HOST se arma para el PC (las
+//pruebas estan en filtro_test.c).
+#if defined(FILTRO_HOST)
+    #include <stdint.h>
+    typedef uint8_t  uint8;
+    typedef uint32_t uint32;
+    typedef int32_t  int32;
+    typedef uint64_t uint64;
+    typedef int64_t  int64;
+#else
+    #include "project.h"
+#endif
+
+#define FILTRO_MEDIANA_MAX  7u
+#define FILTRO_DECIMA_MAX   64u
+#define FILTRO_ORDEN_MAX    2u
+#define FILTRO_IIR_MAX      8u
+#define FILTRO_IIR_FRAC     8u
+
+typedef struct
+{
+    uint8  mediana;         //N, impar de 1 a FILTRO_MEDIANA_MAX
+    uint8  decimacion;      //R, de 1 a FILTRO_DECIMA_MAX
+    uint8  orden;           //orden del CIC, 1 o 2
+    uint8  iir_k;           //constante del IIR, de 0 (sin filtro) a FILTRO_IIR_MAX
+} Filtro_Config;
+
+typedef struct
+{
+    Filtro_Config cfg;
+    int32  ventana[FILTRO_MEDIANA_MAX];
+    uint8  n_ventana;
+    uint8  pos;
+    uint64 integ[FILTRO_ORDEN_MAX];
+    uint64 peine[FILTRO_ORDEN_MAX];     //integrador a la salida anterior, por etapa
+    uint8  fase;                        //muestras desde la ultima salida del CIC
+    uint8  descartar;                   //salidas del transitorio inicial del CIC
+    uint8  hay_iir;
+    int64  iir;                         //con FILTRO_IIR_FRAC bits de fraccion (en 32 bits
+                                        //no entran corrientes de mas de ~8.4 A en uA)
+} Filtro;
+
+uint8 Filtro_Valida(const Filtro_Config *c);
+void  Filtro_Iniciar(Filtro *f, const Filtro_Config *c);
+int32 Filtro_Mediana(Filtro *f, int32 x);
+uint8 Filtro_Cic(Filtro *f, int32 x, int32 *y);
+int32 Filtro_Iir(Filtro *f, int32 x);
+uint8 Filtro_Agregar(Filtro *f, int32 x, int32 *y);
+
+#endif /* FILTRO_H */
+/* [] END OF FILE */
@@ -0,0 +1,244 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+//Pruebas de la cadena de filtros en el PC. No es parte del firmware (no esta en
+//el .cyprj): pasa secuencias conocidas por la mediana, el CIC y el IIR y compara
+//con el resultado esperado. Devuelve 0 si todas pasan.
+//
+//Uso: gcc -std=c99 -Wall -DFILTRO_HOST -o filtro_test filtro_test.c filtro.c && ./filtro_test
+#if defined(FILTRO_HOST)
+
+#include "filtro.h"
+#include <stdio.h>
+#include <stdint.h>
+
+static uint32 fallas;
+
+static void Verificar(uint8 ok, const char *prueba){
+    printf("%-40s %s\n",prueba,(ok!=0u) ? "ok" : "FALLA");
+    if(ok==0u){
+        fallas++;
+    }
+}
+
+static void Configurar(Filtro *f, uint8 mediana, uint8 decimacion, uint8 orden, uint8 iir_k){
+    Filtro_Config c;
+
+    c.mediana=mediana;
+    c.decimacion=decimacion;
+    c.orden=orden;
+    c.iir_k=iir_k;
+    Filtro_Iniciar(f,&c);
+}
+
+static void Probar_Valida(void){
+    Filtro_Config c={5u,8u,2u,3u};
+    uint8 ok=Filtro_Valida(&c);
+
+    c.mediana=4u;
+    ok&=(uint8)(Filtro_Valida(&c)==0u);
+    c.mediana=5u;
+    c.decimacion=0u;
+    ok&=(uint8)(Filtro_Valida(&c)==0u);
+    c.decimacion=FILTRO_DECIMA_MAX+1u;
+    ok&=(uint8)(Filtro_Valida(&c)==0u);
+    c.decimacion=8u;
+    c.orden=FILTRO_ORDEN_MAX+1u;
+    ok&=(uint8)(Filtro_Valida(&c)==0u);
+    c.orden=2u;
+    c.iir_k=FILTRO_IIR_MAX+1u;
+    ok&=(uint8)(Filtro_Valida(&c)==0u);
+    Verificar(ok,"valida: rangos de la configuracion");
+}
+
+//N=1, R=1, k=0: la salida es la entrada
+static void Probar_Identidad(void){
+    Filtro f;
+    uint8 ok=1u;
+    int32 k;
+
+    Configurar(&f,1u,1u,1u,0u);
+    for(k=-500;k<500;k+=7){
+        int32 y=0;
+        int32 x=k*k*((k<0) ? -1 : 1);
+
+        ok&=(uint8)((Filtro_Agregar(&f,x,&y)==1u) && (y==x));
+    }
+    Verificar(ok,"cadena: identidad con N=1 R=1 k=0");
+}
+
+//Un pico aislado no pasa; un escalon pasa con (N-1)/2 muestras de retardo
+static void Probar_Mediana(void){
+    Filtro f;
+    uint8 ok=1u;
+    uint32 k;
+
+    Configurar(&f,5u,1u,1u,0u);
+    for(k=0;k<40u;k++){
+        int32 x=((k==10u) || (k==25u)) ? 30000 : 100;
+
+        ok&=(uint8)(Filtro_Mediana(&f,x)==100);
+    }
+    Verificar(ok,"mediana 5: pico aislado rechazado");
+
+    ok=1u;
+    Configurar(&f,5u,1u,1u,0u);
+    for(k=0;k<20u;k++){
+        int32 x=(k<10u) ? -200 : 800;
+        int32 esperado=(k<12u) ? -200 : 800;
+
+        ok&=(uint8)(Filtro_Mediana(&f,x)==esperado);
+    }
+    Verificar(ok,"mediana 5: escalon con 2 muestras de retardo");
+}
+
+//Orden 1: promedio de a bloques de R, redondeado
+static void Probar_Cic_Promedio(void){
+    static const int32 x[8]={0,2,4,6,8,10,12,-3};
+    Filtro f;
+    int32 y[2];
+    uint8 n=0u,k;
+
+    Configurar(&f,1u,4u,1u,0u);
+    for(k=0;k<8u;k++){
+        int32 s;
+
+        if(Filtro_Cic(&f,x[k],&s)!=0u){
+            if(n<2u){
+                y[n]=s;
+            }
+            n++;
+        }
+    }
+    //(8+10+12-3)/4 = 6.75 -> 7
+    Verificar((uint8)((n==2u) && (y[0]==3) && (y[1]==7)),"cic orden 1 R=4: promedio decimado");
+}
+
+//Orden 2: la primera salida se descarta y despues la ganancia es 1 exacta
+static void Probar_Cic_Ganancia(void){
+    Filtro f;
+    uint8 ok=1u;
+    uint32 n=0u,k;
+    int32 ant=0;
+
+    Configurar(&f,1u,7u,2u,0u);
+    for(k=0;k<700u;k++){
+        int32 y;
+
+        if(Filtro_Cic(&f,-777,&y)!=0u){
+            ok&=(uint8)(y==-777);
+            n++;
+        }
+    }
+    Verificar((uint8)(ok && (n==99u)),"cic orden 2 R=7: ganancia 1, transitorio");
+
+    ok=1u;
+    Configurar(&f,1u,8u,2u,0u);
+    for(k=0;k<400u;k++){
+        int32 y;
+
+        if(Filtro_Cic(&f,(k<200u) ? 0 : 1000,&y)!=0u){
+            ok&=(uint8)((y>=ant) && (y<=1000));
+            ant=y;
+        }
+    }
+    Verificar((uint8)(ok && (ant==1000)),"cic orden 2 R=8: escalon monotono a 1000");
+}
+
+//Los integradores dan la vuelta en 64 bits sin error en la salida
+static void Probar_Cic_Vuelta(void){
+    Filtro f;
+    uint8 ok=1u;
+    uint32 k;
+
+    Configurar(&f,1u,8u,1u,0u);
+    f.integ[0]=UINT64_MAX-50u;
+    f.peine[0]=UINT64_MAX-50u;
+    for(k=0;k<64u;k++){
+        int32 y;
+
+        if(Filtro_Cic(&f,10,&y)!=0u){
+            ok&=(uint8)(y==10);
+        }
+    }
+    Verificar(ok,"cic: vuelta de los integradores");
+}
+
+//k=3: el primer valor arranca el filtro, despues y += (x-y)/8 y llega al final
+static void Probar_Iir(void){
+    Filtro f;
+    int32 y1,y,ant;
+    uint8 ok=1u;
+    uint32 k;
+
+    Configurar(&f,1u,1u,1u,3u);
+    ok&=(uint8)(Filtro_Iir(&f,0)==0);
+    y1=Filtro_Iir(&f,1000);
+    ant=y1;
+    for(k=0;k<200u;k++){
+        y=Filtro_Iir(&f,1000);
+        ok&=(uint8)((y>=ant) && (y<=1000));
+        ant=y;
+    }
+    Verificar((uint8)(ok && (y1==125) && (ant==1000)),"iir k=3: escalon 125 .. 1000");
+
+    Configurar(&f,1u,1u,1u,3u);
+    ok=(uint8)(Filtro_Iir(&f,-4321)==-4321);
+    Verificar(ok,"iir: arranca en el primer valor");
+}
+
+//Corrientes grandes en uA (INA260 a 40 A, shunts chicos): el IIR no puede
+//desbordar al escalar por 2^FILTRO_IIR_FRAC
+static void Probar_Grandes(void){
+    Filtro f;
+    int32 y,ant;
+    uint8 ok=1u;
+    uint32 k;
+
+    Configurar(&f,1u,1u,1u,3u);
+    ok&=(uint8)(Filtro_Iir(&f,10000000)==10000000);
+    ok&=(uint8)(Filtro_Iir(&f,-40000000)==3750000);     //10e6 + (-50e6)/8
+    ant=3750000;
+    for(k=0;k<300u;k++){
+        y=Filtro_Iir(&f,-40000000);
+        ok&=(uint8)((y<=ant) && (y>=-40000000));
+        ant=y;
+    }
+    Verificar((uint8)(ok && (ant==-40000000)),"iir k=3: escalon de +10 A a -40 A en uA");
+
+    ok=1u;
+    Configurar(&f,5u,8u,2u,FILTRO_IIR_MAX);
+    for(k=0;k<4000u;k++){
+        int32 s;
+
+        if(Filtro_Agregar(&f,((k & 1u)!=0u) ? 2000000001 : 2000000000,&s)!=0u){
+            ok&=(uint8)((s>=2000000000) && (s<=2000000001));
+            y=s;
+        }
+    }
+    Verificar((uint8)(ok && ((y==2000000000) || (y==2000000001))),"cadena: entrada cerca del fondo de int32");
+}
+
+int main(void){
+    Probar_Valida();
+    Probar_Identidad();
+    Probar_Mediana();
+    Probar_Cic_Promedio();
+    Probar_Cic_Ganancia();
+    Probar_Cic_Vuelta();
+    Probar_Iir();
+    Probar_Grandes();
+    printf("#FILTRO pruebas fallidas=%lu\n",(unsigned long)fallas);
+    return (fallas!=0u) ? 1 : 0;
+}
+
+#endif /* FILTRO_HOST */
+/* [] END OF FILE */
@@ -0,0 +1,127 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "histograma.h"
+#include "consola.h"
+#include <stdio.h>
+#include <string.h>
+
+static uint32 ms[HIST_N];
+static uint32 t_anterior;
+static uint8  hay_anterior;
+static uint32 dt_max = 0xFFFFFFFFu;     //ms maximos por muestra (Histograma_Periodo)
+
+//Consulta por UART: se copia el histograma y se manda una cubeta por pasada de Idle
+static uint32 copia[HIST_N];
+static uint8  volcando;
+static uint8  volcar_i;
+static uint64 volcar_total;
+
+void Histograma_Reiniciar(void){
+    memset(ms,0,sizeof(ms));
+    hay_anterior=0u;
+}
+
+//Sigue desde lo guardado en flash (0 si no hay nada guardado)
+void Histograma_Restaurar(const uint32 *guardado){
+    Histograma_Reiniciar();
+    if(guardado!=0){
+        memcpy(ms,guardado,sizeof(ms));
+    }
+}
+
+//Tiempo constante: un CLZ y dos desplazamientos, sin buscar en una tabla de limites
+EN_RAM uint8 Histograma_Indice(uint32 mw){
+    uint32 octava,i;
+
+    if(mw<HIST_LINEAL){
+        return (uint8)mw;
+    }
+    octava=31u-__CLZ(mw);       //>=2
+    i=4u*(octava-1u)+((mw>>(octava-2u)) & 3u);
+    return (uint8)((i<HIST_N) ? i : (HIST_N-1u));
+}
+
+//Limite inferior de la cubeta i en mW (la cubeta va hasta el de la siguiente)
+uint32 Histograma_Limite_mw(uint8 i){
+    if(i<HIST_LINEAL){
+        return i;
+    }
+    return (4u+(i & 3u))<<((i>>2)-1u);
+}
+
+//Periodo nominal entre muestras; cada una suma a lo sumo dos
+void Histograma_Periodo(uint32 periodo_ms){
+    dt_max=2u*((periodo_ms!=0u) ? periodo_ms : 1u);
+}
+
+EN_RAM void Histograma_Agregar(const Muestra *m){
+    uint32 mw=(uint32)((m->potencia_mw<0) ? -m->potencia_mw : m->potencia_mw);
+    uint32 *c;
+    uint32 dt;
+
+    if(hay_anterior==0u){
+        hay_anterior=1u;
+        t_anterior=m->t_ms;
+        return;
+    }
+    dt=m->t_ms-t_anterior;
+    t_anterior=m->t_ms;
+    if(dt>dt_max){
+        dt=dt_max;
+    }
+    c=&ms[Histograma_Indice(mw)];
+    *c=((*c+dt)<*c) ? 0xFFFFFFFFu : (*c+dt);
+}
+
+void Histograma_Copiar(uint32 *dst){
+    memcpy(dst,ms,sizeof(ms));
+}
+
+//"#HIST total= s cubetas=N" y despues una linea por cubeta no vacia:
+//"#H i desde= mW ms= permil=". No bloquea la tarea de comandos con 60 lineas.
+void Histograma_Volcar(void){
+    uint8 i,n=0;
+
+    Histograma_Copiar(copia);
+    volcar_total=0u;
+    for(i=0;i<HIST_N;i++){
+        if(copia[i]!=0u){
+            volcar_total+=copia[i];
+            n++;
+        }
+    }
+    printf("#HIST total=%lu s cubetas=%u\r\n",(uint32)(volcar_total/1000u),n);
+    volcar_i=0u;
+    volcando=(uint8)(n!=0u);
+}
+
+void Histograma_Poll(void){
+    if((volcando==0u) || (Consola_Libre()<CONSOLA_LINEA)){
+        return;
+    }
+    while((volcar_i<HIST_N) && (copia[volcar_i]==0u)){
+        volcar_i++;
+    }
+    if(volcar_i>=HIST_N){
+        volcando=0u;
+        return;
+    }
+    printf("#H %u desde=%lu mW ms=%lu permil=%lu\r\n",volcar_i,Histograma_Limite_mw(volcar_i),
+           copia[volcar_i],(uint32)(((uint64)copia[volcar_i]*1000u)/volcar_total));
+    volcar_i++;
+}
+
+uint8 Histograma_Volcando(void){
+    return volcando;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,43 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef HISTOGRAMA_H
+#define HISTOGRAMA_H
+
+#include "project.h"
+#include "ramfunc.h"
+#include "medicion.h"
+
+//Histograma de tiempo por nivel de potencia (modulo, en mW), para dimensionar
+//fuentes sin bajar el flujo crudo al PC. Cubetas fijas espaciadas en escala log:
+//las 4 primeras son 0, 1, 2 y 3 mW y despues hay 4 por octava (el bit mas alto
+//da la octava con un CLZ y los 2 siguientes la cubeta dentro de ella, ~19 % de
+//ancho). La ultima junta todo lo que pasa de su limite inferior (57.3 W).
+//Cada muestra suma a su cubeta los ms desde la muestra anterior (uint32: satura
+//a los ~49 dias por cubeta), con tope de dos periodos de muestreo: despues de un
+//hueco de la adquisicion (barrido, captura, bajo consumo) la primera muestra no
+//se lleva todo el hueco. Se guarda con las filas del registro en flash.
+#define HIST_N              60u     //una fila de flash: 60 x uint32 detras del encabezado
+#define HIST_LINEAL         4u      //cubetas de 1 mW al principio
+
+void   Histograma_Reiniciar(void);
+void   Histograma_Restaurar(const uint32 *ms);
+void   Histograma_Periodo(uint32 periodo_ms);
+EN_RAM void Histograma_Agregar(const Muestra *m);
+EN_RAM uint8 Histograma_Indice(uint32 mw);
+uint32 Histograma_Limite_mw(uint8 i);
+void   Histograma_Copiar(uint32 *ms);
+void   Histograma_Volcar(void);
+void   Histograma_Poll(void);
+uint8  Histograma_Volcando(void);
+
+#endif /* HISTOGRAMA_H */
+/* [] END OF FILE */
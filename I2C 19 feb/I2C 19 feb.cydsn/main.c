@@ -13,28 +13,67 @@
 #include "stdio.h"
 #include "stdlib.h"
 #include "string.h"
-#define SlaveAddress 0x40      //Dirección esclavo; esclavo=Recibe la señal de sincronismo y ejecuta órdenes del maestro 
+#include "timebase.h"
+#include "medicion.h"
+#include "display.h"
+#include "sched.h"
+#include "ringbuf.h"
+#include "adquisicion.h"
+#include "perfil.h"
+#include "ramfunc.h"
+#include "banco.h"
+#include "config.h"
+#include "registro.h"
+#include "respaldo.h"
+#include "ahorro.h"
+#include "escala.h"
+#include "vigia.h"
+#include "captura.h"
+#include "alarma.h"
+#include "barrido.h"
+#include "filtro.h"
+#include "pulso.h"
+#include "histograma.h"
+#include "bateria.h"
+#include "eficiencia.h"
+#include "consola.h"
+
+//Tasas independientes (Hz), todas derivadas de la base de tiempo de Timer_1.
+//Muestreo, UART y LCD salen de la configuracion guardada (config.c); estos son
+//los valores con que arranca la tabla antes de leerla.
+#define RATE_MUESTREO_HZ      50u   //lectura del INA219
+#define RATE_ESTADISTICA_HZ   1u    //cierre de la ventana de promedios
+#define RATE_UART_HZ          1u    //reporte al PC
+#define RATE_LCD_HZ           4u    //refresco de la LCD
+#define RATE_REGISTRO_HZ      25u   //pasos de escritura del registro en flash
+#define RATE_RESPALDO_HZ      100u  //sondeo del detector de baja tension
+#define RATE_BARRIDO_HZ       10u   //cierre de las ventanas del barrido del ADC
+
+//Tareas del planificador, en orden de prioridad
+enum
+{
+    T_RESPALDO = 0u,    //guardado de la energia por baja tension o punto de control
+    T_PROCESAR,         //conversion, ventana y energia (evento de I2C_ISR)
+    T_ALARMA,           //aviso por UART de los cambios de las alarmas (evento de I2C_ISR)
+    T_ESTADISTICA,      //cierre de la ventana
+    T_COMANDOS,         //comandos del PC (evento de isr_Rx)
+    T_TRANSMITIR,       //reporte por UART
+    T_DISPLAY,          //refresco de la LCD
+    T_REGISTRO,         //escritura de filas del registro en flash
+    T_BARRIDO,          //barrido del ADC del sensor (solo hace algo si se pidio con 'A')
+    T_TASAS,            //reporte de tasas y plazos
+    T_ARRANQUE,         //banner de arranque (evento de la primera muestra y de la LCD)
+    N_TAREAS
+};
 //asm(".global_printf_float");
+//printf solo encola: la ISR del tick vacia la cola a la UART (consola.c)
 int _write(int file, char *ptr, int len){
  file=file;
-   int i;
-   for(i=0;i<len;i++){
-     UART_PutChar(*ptr++);
-    
-   }
-   return len;
+   return Consola_Escribir(ptr,len);
 }
 
-uint8 result,i,Tabla[4],valorpotencia;
-uint16 angulo;
-uint16 voltaje_shunt,voltaje_shunt2,vbus,vbus2,Datos2,Datos,corriente,potencia;
-int flag;
-float factor_lsb_Corriente;
-uint8 h=8,g=6;
-uint8 vs1,vs2;
-uint32 time;
-float pot=0;
-const uint8 string2[4]="0123";
+volatile int flag;
+uint8 pedir_tasas=0;    //'r': manda las lineas de diagnostico del proximo segundo
 
 //SDA= Aquí viajan los datos como tal 
 //I2C es un protocolo síncrono. I2C usa solo 2 cables, 
@@ -43,188 +82,725 @@ const uint8 string2[4]="0123";
 //el cual es controlado por el maestro, que crea la señal de reloj.
 //I2C no utiliza selección de esclavo, sino direccionamiento.
 
+RING_DEFINIR(Ring_Rx, char, 32u)
+Ring_Rx cola_rx;
+
+//La ISR solo encola los bytes recibidos y despierta la tarea de comandos
+EN_RAM CY_ISR(Rx){
+
+    Banco_Entrada();
+    PERFIL_INICIO(PF_ISR_RX);
+    while((UART_ReadRxStatus() & UART_RX_STS_FIFO_NOTEMPTY)!=0u){
+        (void)Ring_Rx_Push(&cola_rx,(char)UART_ReadRxData());
+    }
+    Sched_Signal(T_COMANDOS);
+     isr_Rx_ClearPending();
+    PERFIL_FIN(PF_ISR_RX);
+}
+
+Muestra muestra;
+Ventana ventana;
+Resumen resumen;
+Totales totales;
+uint32 err_i2c=0;
 
+uint32 lecturas_i2c=0;
+uint32 muestras_seg=0;  //muestras procesadas desde el ultimo cierre de ventana
+uint32 muestras_ant=0;  //muestras del ultimo segundo cerrado
+uint32 solapes=0;
+uint8  origen_config=CONFIG_VACIA;
+uint8  origen_respaldo=RESPALDO_VACIO;
+uint32 t_primera=0;     //ms desde el arranque hasta la primera muestra procesada
+uint8  hay_primera=0;
 
-//CY_ISR(Rx){
-//
-//    char Value_Init;
-//    Value_Init=UART_GetChar();
-//    if(Value_Init == 'a'){
-//      flag=1;
-//    
-//    }
-//     isr_Rx_ClearPending();
-//}
-
-void Get_voltage_shunt(uint8 add_slave, uint8 add_regist){
-            I2C_MasterSendRestart(add_slave,I2C_WRITE_XFER_MODE);
-            I2C_MasterWriteByte(add_regist);
-            I2C_MasterSendRestart(add_slave,I2C_READ_XFER_MODE);
-            voltaje_shunt=I2C_MasterReadByte(add_regist);     
-          
-            voltaje_shunt2=I2C_MasterReadByte(I2C_ACK_DATA);
-            
-            voltaje_shunt=voltaje_shunt<<8;
-            voltaje_shunt=voltaje_shunt2+voltaje_shunt;
-            
-            //voltaje_shunt=~(voltaje_shunt)+1;
-            
-            //I2C_MasterSendStop();    
-            //return voltaje_shunt;
+Pulso  pulsos;      //analizador de carga pulsada sobre las muestras sin filtrar
+Filtro filtro_i;
+Filtro filtro_v;
+Filtro filtro_p;    //la potencia se filtra aparte: prom(V*I) no es prom(V)*prom(I)
+Muestra filtrada;
+uint32 filtro_ciclos=0;     //ciclos de la cadena de filtros desde el ultimo reporte
+uint32 filtro_peor=0;       //peor caso por muestra
+uint32 filtro_entradas=0;
+uint32 filtro_salidas=0;
+
+//Cadena de filtros sobre corriente, tension y potencia (filtro.h). La potencia
+//instantanea de cada muestra pasa por su propio filtro: con decimacion o IIR el
+//producto de V e I filtradas se aleja del promedio real en cargas pulsadas.
+//Devuelve 1 cuando hay una salida decimada en "f"
+uint8 Filtrar(const Muestra *m, Muestra *f){
+    uint32 c0=DWT->CYCCNT;
+    uint32 ciclos;
+    int32 i,v,p;
+    uint8 hay;
+    
+    hay=Filtro_Agregar(&filtro_i,m->corriente_ua,&i);
+    (void)Filtro_Agregar(&filtro_v,(int32)m->vbus_mv,&v);
+    (void)Filtro_Agregar(&filtro_p,m->potencia_mw,&p);
+    if(hay){
+        f->t_ms=m->t_ms;
+        f->t_us=m->t_us;
+        f->corriente_ua=i;
+        f->vbus_mv=(uint16)v;
+        f->potencia_mw=p;
+        filtro_salidas++;
+    }
+    ciclos=DWT->CYCCNT-c0;
+    filtro_ciclos+=ciclos;
+    filtro_entradas++;
+    if(ciclos>filtro_peor){
+        filtro_peor=ciclos;
+    }
+    return hay;
+}
+
+//Vacia las colas que llena I2C_ISR: eventos de fin de transaccion y muestras crudas.
+//La ventana de 1 s recibe la salida de los filtros; la energia se integra con
+//todas las muestras sin filtrar.
+void Procesar(){
+    Evento_I2C e;
+    Crudo c;
+    Par par;
+    Muestra entrada,salida;
+    
+    //periodo nominal en ms (ticks de 1 ms) para el tope del histograma: el del
+    //muestreo, o el del CTW en bajo consumo (una muestra por despertar)
+    Histograma_Periodo((Ahorro_Estado()!=AHORRO_APAGADO) ? (1u<<AHORRO_CTW_INTERVALO) :
+                       (TIMEBASE_TICK_HZ/Config_Get()->muestreo_hz));
+    while(Ring_Evento_Pop(&cola_eventos,&e)){
+        if(e.tipo==EV_I2C_OK){
+            lecturas_i2c++;
+        }else if(e.tipo==EV_I2C_ERROR){
+            err_i2c++;
+        }else{
+            solapes++;
         }
-        
-void Get_voltage_bus(uint8 add_slave, uint8 add_regist){
-            I2C_MasterSendRestart(add_slave,I2C_WRITE_XFER_MODE);
-            I2C_MasterWriteByte(add_regist);
-            I2C_MasterSendRestart(add_slave,I2C_READ_XFER_MODE);
-            vbus=I2C_MasterReadByte(add_regist);
-            vs1=vbus;///////////////////////////////////////////
-//            UART_PutCRLF(vs1);
-            vbus2=I2C_MasterReadByte(I2C_ACK_DATA);
-            vs2=vbus2;//////////////////////////////////////////
-//            UART_PutCRLF(vs2);
-            vbus=vbus<<8;
-            vbus=vbus2+vbus;  
-            vbus=vbus>>3;
-            
-            //I2C_MasterSendStop();    
-            //return voltaje_shunt;
+    }
+    while(Ring_Crudo_Pop(&cola_muestras,&c)){
+        PERFIL_INICIO(PF_CONVERSION);
+        Medicion_Convertir(c.shunt,c.bus,c.t_ms,c.t_us,&muestra);
+        if(Filtrar(&muestra,&filtrada)){
+            Ventana_Agregar(&ventana,&filtrada);
         }
-        
-void Get_Corriente(){
-     factor_lsb_Corriente=(3/32768);
-        I2C_MasterSendRestart(SlaveAddress, I2C_WRITE_XFER_MODE);
-        I2C_MasterWriteByte(0x05);
-        I2C_MasterWriteByte(0x11);
-        I2C_MasterWriteByte(0x7C);
-        
-      I2C_MasterSendRestart(SlaveAddress, I2C_WRITE_XFER_MODE);
-      I2C_MasterWriteByte(0x03);  
-      I2C_MasterSendRestart(SlaveAddress,I2C_READ_XFER_MODE);
-      Datos=I2C_MasterReadByte(0x03);
-      Datos<<=8;
-      Datos+=I2C_MasterReadByte(I2C_ACK_DATA);
-      corriente=Datos<<1;
-     // i2c_MasterSendStop();
+        Totales_Integrar(&totales,&muestra);
+        Bateria_Agregar(&muestra);
+        PERFIL_FIN(PF_CONVERSION);
+        Pulso_Agregar(&pulsos,&muestra);
+        Histograma_Agregar(&muestra);
+        Barrido_Agregar(&muestra,err_i2c+solapes);
+        muestras_seg++;
+        if(hay_primera==0u){
+            hay_primera=1u;
+            t_primera=Timebase_Now();
+            Sched_Signal(T_ARRANQUE);
+        }
+    }
+    //modo eficiencia: pares entrada/salida de los dos sensores
+    while(Ring_Par_Pop(&cola_pares,&par)){
+        Medicion_Convertir(par.shunt[0],par.bus[0],par.t_ms,par.t_us,&entrada);
+        Medicion_Convertir(par.shunt[1],par.bus[1],par.t_ms,par.t_us,&salida);
+        Eficiencia_Agregar(&entrada,&salida,par.sesgo_us);
+    }
+}
 
+//Cierra la ventana de 1 s y la suma al resumen del registro en flash. El segundo
+//del watchdog se cuenta aca y no en el reporte de tasas, que puede no correr
+void Cerrar_Ventana(){
+    Vigia_Segundo((uint8)(muestras_seg!=0u));
+    muestras_ant=muestras_seg;
+    muestras_seg=0;
+    Bateria_Segundo();
+    if(Ventana_Cerrar(&ventana,&resumen)){
+        Registro_Agregar(&resumen,Totales_Energia_mWh(&totales),Timebase_Now()/TIMEBASE_TICK_HZ);
+    }
 }
 
-        
-void Get_Potencia(){
-    // factor_lsb_Corriente=(3/32768);
-       // float factor_lsb_potencia=factor_lsb_Corriente*20;
+void Barrer_ADC(){
+    Barrido_Tarea(err_i2c+solapes);
+}
+
+//La energia de Totales ya incluye lo guardado antes del ultimo reset
+void Respaldar(){
+    Respaldo_Tarea(totales.energia_mwms);
+}
+
+void Refrescar_LCD();
+void Reportar_UART();
+void Reportar_Tasas();
+static void Imprimir_Tasas(uint32 idle, const Pulso_Resumen *rp, const Eficiencia_Resumen *ef);
+static void Imprimir_Ahorro(void);
+void Aplicar_Config();
+void Mostrar_Config();
+const char *Nombre_Tarea(uint8 id);
+
+//Linea de configuracion "Cxx=valor" (terminada en CR o LF); queda en preparacion
+//hasta que se guarda con 'W'
+void Comando_Config(const char *linea){
+    Config *c=Config_Editar();
+    long v;
+    
+    if((strlen(linea)<4u) || (linea[2]!='=')){
+        printf("#CONFIG ?\r\n");
+        return;
+    }
+    v=strtol(&linea[3],NULL,0);
+    if(strncmp(linea,"rs",2)==0){
+        c->rshunt_mohm=(uint16)v;
+    }else if(strncmp(linea,"gp",2)==0){
+        c->ganancia_ppm=(int32)v;
+    }else if(strncmp(linea,"of",2)==0){
+        c->offset_ua=(int32)v;
+    }else if(strncmp(linea,"ic",2)==0){
+        c->ina_config=(uint16)v;
+    }else if(strncmp(linea,"mu",2)==0){
+        c->muestreo_hz=(uint16)v;
+    }else if(strncmp(linea,"tx",2)==0){
+        c->uart_hz=(uint16)v;
+    }else if(strncmp(linea,"lc",2)==0){
+        c->lcd_hz=(uint16)v;
+    }else if(strncmp(linea,"fm",2)==0){
+        c->formato=(uint8)v;
+    }else if(strncmp(linea,"ch",2)==0){
+        c->canales=(uint8)v;
+    }else if(strncmp(linea,"ai",2)==0){
+        c->alarma_ma=(int32)v;
+    }else if(strncmp(linea,"av",2)==0){
+        c->alarma_mv=(uint16)v;
+    }else if(strncmp(linea,"ap",2)==0){
+        c->alarma_mw=(int32)v;
+    }else if(strncmp(linea,"ah",2)==0){
+        c->histeresis_pct=(uint8)v;
+    }else if(strncmp(linea,"ar",2)==0){
+        c->rebote=(uint8)v;
+    }else if(strncmp(linea,"fn",2)==0){
+        c->filtro_mediana=(uint8)v;
+    }else if(strncmp(linea,"fr",2)==0){
+        c->filtro_decima=(uint8)v;
+    }else if(strncmp(linea,"fo",2)==0){
+        c->filtro_orden=(uint8)v;
+    }else if(strncmp(linea,"fi",2)==0){
+        c->filtro_iir=(uint8)v;
+    }else if(strncmp(linea,"bc",2)==0){
+        c->bat_mah=(uint16)v;
+    }else if(strncmp(linea,"bl",2)==0){
+        c->bat_lleno_mv=(uint16)v;
+    }else if(strncmp(linea,"bv",2)==0){
+        c->bat_vacio_mv=(uint16)v;
+    }else if(strncmp(linea,"bt",2)==0){
+        c->bat_cola_ma=(uint16)v;
+    }else if(strncmp(linea,"pt",2)==0){
+        Captura_SetPre((v>0) ? (uint32)v : 0u);    //la captura no se guarda en la flash
+        printf("#CAPTURA pre=%lu\r\n",Captura_Pre());
+        return;
+    }else if(strncmp(linea,"pu",2)==0){
+        Pulso_Iniciar(&pulsos,(int32)v);    //umbral de pulsos en mA, 0 = automatico
+        printf("#PULSOS umbral=%ld mA\r\n",v);
+        return;
+    }else if(strncmp(linea,"ut",2)==0){
+        Captura_SetUmbral((int32)v);
+        printf("#CAPTURA umbral=%ld mA\r\n",v);
+        return;
+    }else{
+        printf("#CONFIG ?\r\n");
+        return;
+    }
+    printf("#CONFIG pendiente=%u\r\n",Config_Pendiente());
+}
+
+//Comandos del PC: 'p' pasa a la siguiente pagina de la LCD, '0'..'3' elige una,
+//'r' pide las lineas de diagnostico (#TAREAS, #COLAS, ...) del proximo segundo,
+//'q' reinicia los maximos de ocupacion de las colas, 'c' vuelca y reinicia el perfil,
+//'b' corre el banco de pruebas flash/SRAM, 'L' vuelca el registro de la flash,
+//'Z' pone en cero la energia y el tiempo de funcionamiento guardados, 'S' entra o
+//sale del modo de bajo consumo, 'G' prende o apaga el gobernador del reloj de bus,
+//'X' arma la captura de forma de onda y 'T' la dispara a mano ("Cpt=" muestras
+//previas al disparo, "Cut=" umbral en mA), 'A' barre los tiempos de conversion
+//del ADC (o corta el barrido en curso), 'H' manda el histograma de potencia y 'h'
+//lo borra, 'B' marca la bateria como llena, 'E' prende o apaga el modo eficiencia
+//(dos sensores, entrada y salida de un convertidor). Configuracion: "Cxx=valor" prepara un
+//cambio, 'W' lo guarda y aplica, 'D' prepara los valores por defecto, 'K' la muestra.
+void Atender_Comando(){
+    static char linea[16];
+    static uint8 n_linea=0,en_linea=0;
+    char Value_Init;
     
-        I2C_MasterSendRestart(SlaveAddress, I2C_WRITE_XFER_MODE);
-        I2C_MasterWriteByte(0x05);
-        I2C_MasterWriteByte(0x18);
-        I2C_MasterWriteByte(0xf7);
+    while(Ring_Rx_Pop(&cola_rx,&Value_Init)){
+        if(en_linea!=0u){
+            if((Value_Init=='\r') || (Value_Init=='\n')){
+                linea[n_linea]='\0';
+                en_linea=0u;
+                Comando_Config(linea);
+            }else if(n_linea<(sizeof(linea)-1u)){
+                linea[n_linea++]=Value_Init;
+            }
+            continue;
+        }
+        if(Value_Init == 'C'){
+          en_linea=1u;
+          n_linea=0u;
+        }
+        if(Value_Init == 'W'){
+          cy_en_em_eeprom_status_t r;
+          Barrido_Cancelar();
+          r=Config_Guardar();
+          Aplicar_Config();
+          printf("#CONFIG guardar=%lu escrituras=%lu\r\n",(uint32)r,Config_Escrituras());
+        }
+        if(Value_Init == 'D'){
+          Config_Defecto(Config_Editar());
+          printf("#CONFIG pendiente=%u\r\n",Config_Pendiente());
+        }
+        if(Value_Init == 'K'){
+          Mostrar_Config();
+        }
+        if(Value_Init == 'a'){
+          flag=1;
         
-      I2C_MasterSendRestart(SlaveAddress, I2C_WRITE_XFER_MODE);
-      I2C_MasterWriteByte(0x04);  
-      I2C_MasterSendRestart(SlaveAddress,I2C_READ_XFER_MODE);
-      Datos=I2C_MasterReadByte(0x04);
-      Datos<<=8;
-      Datos+=I2C_MasterReadByte(I2C_ACK_DATA);
-      potencia=Datos;
-     // i2c_MasterSendStop();
+        }
+        if(Value_Init == 'r'){
+          pedir_tasas=1;
+        }
+        if(Value_Init == 'p'){
+          Display_NextPage();
+        }
+        if((Value_Init >= '0') && (Value_Init < (char)('0'+PAGINAS))){
+          Display_SetPage((uint8)(Value_Init-'0'));
+        }
+        if(Value_Init == 'c'){
+          Perfil_Dump();
+          Perfil_Reset();
+        }
+        if(Value_Init == 'b'){
+          Banco_Ejecutar();
+        }
+        if((Value_Init == 'L') && (Captura_Volcando()==0u)){
+          Registro_Volcar();
+        }
+        if((Value_Init == 'H') && (Registro_Volcando()==0u) && (Captura_Volcando()==0u)){
+          Histograma_Volcar();
+        }
+        if(Value_Init == 'h'){
+          Histograma_Reiniciar();
+          Registro_Guardar_Histograma();
+          printf("#HIST borrar\r\n");
+        }
+        if(Value_Init == 'E'){
+          Captura_Cancelar();
+          Barrido_Cancelar();
+          Eficiencia_Reiniciar();
+          Adquisicion_SetDual((uint8)(Adquisicion_Dual()==0u));
+          printf("#EFICIENCIA on=%u\r\n",Adquisicion_Dual());
+        }
+        if(Value_Init == 'B'){
+          Bateria_Llena();
+          printf("#BATERIA llena\r\n");
+        }
+        if(Value_Init == 'Z'){
+          totales.energia_mwms=0;
+          Bateria_Borrar();
+          printf("#RESPALDO borrar=%lu\r\n",(uint32)Respaldo_Guardar(0,RESPALDO_BORRADO));
+        }
+        if(Value_Init == 'S'){
+          if(Ahorro_Estado()==AHORRO_APAGADO){
+            Captura_Cancelar();
+            Barrido_Cancelar();
+            Ahorro_Entrar();
+            printf("#AHORRO entrar\r\n");
+          }else{
+            Ahorro_Salir();
+            printf("#AHORRO salir\r\n");
+          }
+        }
+        if(Value_Init == 'X'){
+          //la captura necesita el tick de 1 ms: sale del bajo consumo
+          if(Ahorro_Estado()!=AHORRO_APAGADO){
+            Ahorro_Salir();
+          }
+          Barrido_Cancelar();
+          Adquisicion_SetDual(0u);
+          Captura_Armar(Config_Get()->rshunt_mohm);
+          printf("#CAPTURA armada\r\n");
+        }
+        if(Value_Init == 'A'){
+          if(Barrido_Activo()){
+            Barrido_Cancelar();
+          }else{
+            //el barrido mide en continuo, sin captura ni bajo consumo
+            Captura_Cancelar();
+            if(Ahorro_Estado()!=AHORRO_APAGADO){
+              Ahorro_Salir();
+            }
+            Adquisicion_SetDual(0u);
+            Barrido_Iniciar(Config_Get()->ina_config,Config_Get()->muestreo_hz);
+          }
+        }
+        if(Value_Init == 'T'){
+          Captura_Disparar();
+        }
+        if(Value_Init == 'G'){
+          Escala_Habilitar((uint8)(Escala_Habilitado()==0u));
+        }
+        if(Value_Init == 'q'){
+          (void)Ring_Rx_ResetMaximo(&cola_rx);
+          (void)Ring_Crudo_ResetMaximo(&cola_muestras);
+          (void)Ring_Evento_ResetMaximo(&cola_eventos);
+          Consola_ResetMaximo();
+        }
+    }
+}
+
+//Banner de arranque: se envia con la primera muestra (que sale en la misma
+//linea) y otra vez cuando la LCD termina de inicializarse en segundo plano
+void Arranque(){
+    static uint8 banner=0,lcd=0;
+    char Value[16]="";
+    
+    if((hay_primera!=0u) && (banner==0u)){
+        banner=1u;
+        lcd=Display_Ready();
+        (void)Medicion_Formato(Value,muestra.potencia_mw,2u);
+        printf("#ARRANQUE %s %s primera_muestra=%lu ms lcd=%lu ms config=%u respaldo=%u arranques=%lu\r\n",
+               PERFIL_BUILD,SENSOR_NOMBRE,t_primera,Display_TiempoArranque(),origen_config,origen_respaldo,Respaldo_Get()->arranques);
+        printf("%lu\t%s\r\n",muestra.t_ms,Value);
+        //causa del reset y, si fue el watchdog, que tarea estaba corriendo
+        printf("#VIGIA reset=0x%02X tarea=%s anterior=%s t=%lu ms ciclo=%lu wdt=%lu\r\n",
+               Vigia_Causa(),Nombre_Tarea(Vigia_Ultimo()->tarea),Nombre_Tarea(Vigia_Ultimo()->anterior),
+               Vigia_Ultimo()->t_ms,Vigia_Ultimo()->ciclo,Vigia_Reinicios());
+    }
+    if((banner!=0u) && (lcd==0u) && Display_Ready()){
+        lcd=1u;
+        printf("#ARRANQUE lcd=%lu ms\r\n",Display_TiempoArranque());
+    }
+}
+
+//Hook del tick de 1 ms: adquisicion y salida de la UART
+EN_RAM static void Tick(void){
+    Adquisicion_Tick();
+    Consola_Tick();
+}
+
+//Antes de cada tarea: el watchdog anota cual corre y el reloj vuelve a maximo
+void Despachar(uint8 id){
+    Vigia_Entrar(id);
+    Escala_Alta();
+}
+
+//La UART esta ocupada con un volcado binario (registro o captura)
+static uint8 UART_Volcando(void){
+    return (uint8)((Registro_Volcando()!=0u) || (Captura_Volcando()!=0u));
+}
+
+//Los cambios de las alarmas esperan en su cola si la UART esta volcando; el pin
+//ya se movio en la ISR
+void Avisar_Alarmas(){
+    if(UART_Volcando()==0u){
+        Alarma_Reportar();
+    }
+}
+
+//Sin tareas listas: baja el reloj de bus, avanza el arranque de la LCD y los
+//volcados, y en bajo consumo duerme si no queda nada por mandar ni capturar
+void Idle(){
+    Vigia_Idle();
+    Escala_Baja();
+    if(Display_Poll()){
+        Sched_Signal(T_ARRANQUE);
+    }
+    Registro_Volcar_Poll();
+    if((UART_Volcando()==0u) && Alarma_Pendientes()){
+        Sched_Signal(T_ALARMA);
+    }
+    if(Registro_Volcando()==0u){
+        Captura_Poll();     //la captura congelada espera a que termine el registro
+    }
+    if(UART_Volcando()==0u){
+        Histograma_Poll();  //una linea por pasada
+    }
+    Ahorro_Poll((uint8)((UART_Volcando()==0u) && (Histograma_Volcando()==0u) &&
+                        (Captura_Estado()==CAPTURA_APAGADA) && Display_Ready()));
+}
+
+Tarea tareas[N_TAREAS]={
+    TAREA_PERIODICA("bkp",Respaldar,RATE_RESPALDO_HZ),
+    TAREA_EVENTO("pro",Procesar,TIMEBASE_MS(10)),
+    TAREA_EVENTO("alm",Avisar_Alarmas,TIMEBASE_MS(10)),
+    TAREA_PERIODICA("est",Cerrar_Ventana,RATE_ESTADISTICA_HZ),
+    TAREA_EVENTO("cmd",Atender_Comando,TIMEBASE_MS(50)),
+    TAREA_PERIODICA("tx",Reportar_UART,RATE_UART_HZ),
+    TAREA_PERIODICA("lcd",Refrescar_LCD,RATE_LCD_HZ),
+    TAREA_PERIODICA("log",Registro_Tarea,RATE_REGISTRO_HZ),
+    TAREA_PERIODICA("adc",Barrer_ADC,RATE_BARRIDO_HZ),
+    TAREA_PERIODICA("tasas",Reportar_Tasas,1u),
+    TAREA_EVENTO("boot",Arranque,0u),
+};
+
+const char *Nombre_Tarea(uint8 id){
+    if(id==VIGIA_IDLE){
+        return "idle";
+    }
+    return (id<N_TAREAS) ? tareas[id].nombre : "?";
+}
+
+//Mascara de las tareas periodicas: son las que tienen que presentarse al watchdog
+uint32 Tareas_Periodicas(){
+    uint32 m=0;
+    uint8 k;
+    
+    for(k=0;k<N_TAREAS;k++){
+        if(tareas[k].hz!=0u){
+            m|=(uint32)1u<<k;
+        }
+    }
+    return m;
+}
+
+uint32 Perdidas(){
+    uint32 total=0;
+    uint8 k;
+    
+    for(k=0;k<N_TAREAS;k++){
+        total+=tareas[k].rate.perdidas+tareas[k].tarde;
+    }
+    return total;
+}
+
+void Refrescar_LCD(){
+    Display_Datos d;
+    
+    d.resumen=resumen;
+    d.energia_mwh=Totales_Energia_mWh(&totales);
+    d.segundos=Timebase_Now()/TIMEBASE_TICK_HZ;
+    d.err_i2c=err_i2c;
+    d.perdidas=Perdidas();
+    Display_Refresh(&d);
+}
+
+void Reportar_UART(){
+        const Config *cfg=Config_Get();
+        char Value[48]="";
+        uint8 n=0;
+        if(UART_Volcando() || Barrido_Activo()){
+            return;     //la UART esta ocupada con el volcado binario
+        }
+        //promedios de la ventana sin printf de punto flotante: V y W con 3 y 2
+        //decimales, I en mA y E en Wh. El formato y los canales son configurables.
+        PERFIL_INICIO(PF_FORMATO);
+        if(cfg->formato==FORMATO_CANALES){
+            if((cfg->canales & CANAL_V)!=0u){
+                Value[n++]='\t';
+                n+=Medicion_Formato(&Value[n],(int32)resumen.vbus_mv,3u);
+            }
+            if((cfg->canales & CANAL_I)!=0u){
+                Value[n++]='\t';
+                n+=Medicion_Formato(&Value[n],resumen.corriente_ua,3u);
+            }
+            if((cfg->canales & CANAL_P)!=0u){
+                Value[n++]='\t';
+                n+=Medicion_Formato(&Value[n],resumen.potencia_mw,2u);
+            }
+            if((cfg->canales & CANAL_E)!=0u){
+                Value[n++]='\t';
+                n+=Medicion_Formato(&Value[n],Totales_Energia_mWh(&totales),3u);
+            }
+        }else{
+            Value[n++]='\t';
+            n+=Medicion_Formato(&Value[n],resumen.potencia_mw,2u);
+        }
+        Value[n]='\0';
+        PERFIL_FIN(PF_FORMATO);
+      ///defini previamente la estructura del envio 
+        PERFIL_INICIO(PF_UART);
+        printf("%lu%s\r\n", Timebase_Now(), Value);
+        PERFIL_FIN(PF_UART);
+}
 
+//Calibracion y tasas de la configuracion activa
+void Aplicar_Config(){
+    const Config *cfg=Config_Get();
+    Filtro_Config f;
+    
+    Medicion_Calibrar(cfg->rshunt_mohm,cfg->ganancia_ppm,cfg->offset_ua);
+    Alarma_Configurar(cfg->alarma_ma,cfg->alarma_mv,cfg->alarma_mw,cfg->histeresis_pct,cfg->rebote);
+    Bateria_Configurar(cfg->bat_mah,cfg->bat_lleno_mv,cfg->bat_vacio_mv,cfg->bat_cola_ma);
+    f.mediana=cfg->filtro_mediana;
+    f.decimacion=cfg->filtro_decima;
+    f.orden=cfg->filtro_orden;
+    f.iir_k=cfg->filtro_iir;
+    Filtro_Iniciar(&filtro_i,&f);
+    Filtro_Iniciar(&filtro_v,&f);
+    Filtro_Iniciar(&filtro_p,&f);
+    Adquisicion_SetConfig(cfg->ina_config);
+    Adquisicion_SetRate(cfg->muestreo_hz);
+    Rate_Init(&tareas[T_TRANSMITIR].rate,cfg->uart_hz);
+    Rate_Init(&tareas[T_DISPLAY].rate,cfg->lcd_hz);
+    tareas[T_TRANSMITIR].hz=cfg->uart_hz;
+    tareas[T_DISPLAY].hz=cfg->lcd_hz;
+    tareas[T_TRANSMITIR].plazo=tareas[T_TRANSMITIR].rate.periodo;
+    tareas[T_DISPLAY].plazo=tareas[T_DISPLAY].rate.periodo;
 }
-CY_ISR(timer){
-  time++;
-  isr_timer_ClearPending();
+
+void Mostrar_Config(){
+    const Config *c=Config_Get();
+    
+    printf("#CONFIG v%u rs=%u gp=%ld of=%ld ic=0x%04X mu=%u tx=%u lc=%u fm=%u ch=0x%02X"
+           " ai=%ld av=%u ap=%ld ah=%u ar=%u fn=%u fr=%u fo=%u fi=%u bc=%u bl=%u bv=%u bt=%u crc=0x%04X\r\n",
+           c->version,c->rshunt_mohm,c->ganancia_ppm,c->offset_ua,c->ina_config,
+           c->muestreo_hz,c->uart_hz,c->lcd_hz,c->formato,c->canales,
+           c->alarma_ma,c->alarma_mv,c->alarma_mw,c->histeresis_pct,c->rebote,
+           c->filtro_mediana,c->filtro_decima,c->filtro_orden,c->filtro_iir,
+           c->bat_mah,c->bat_lleno_mv,c->bat_vacio_mv,c->bat_cola_ma,c->crc);
+}
+
+//Por tarea: tasa lograda en el ultimo segundo (o ejecuciones si es por evento) /
+//ejecuciones fuera de plazo / peor tiempo en ticks. Al final, pasadas en idle.
+static void Imprimir_Tasas(uint32 idle, const Pulso_Resumen *rp, const Eficiencia_Resumen *ef){
+    Rate *r;
+    Bateria_Estado be;
+    uint8 k;
+    
+    printf("#TAREAS");
+    for(k=0;k<N_TAREAS;k++){
+        Tarea *t=&tareas[k];
+        printf(" %s=%u/%lu/%lu",t->nombre,t->rate.lograda_hz,t->tarde,t->peor_ticks);
+    }
+    printf(" idle=%lu\r\n",idle);
+    //Colas ISR -> tareas: ocupacion maxima / descartes
+    printf("#COLAS rx=%lu/%lu mu=%lu/%lu ev=%lu/%lu tx=%lu/%lu i2c ok=%lu err=%lu solape=%lu\r\n",
+           Ring_Rx_Maximo(&cola_rx),cola_rx.desbordes,
+           Ring_Crudo_Maximo(&cola_muestras),cola_muestras.desbordes,
+           Ring_Evento_Maximo(&cola_eventos),cola_eventos.desbordes,
+           Consola_Maximo(),Consola_Perdidos(),
+           lecturas_i2c,err_i2c,solapes);
+    //Reporte de 1 Hz: desvio del periodo min..max / atraso maximo en ticks de Timer_1,
+    //y corrimiento de fase respecto a la grilla original. "us" son los 32 bits bajos
+    //del reloj en us, para alinear con las marcas de otros equipos
+    r=&tareas[T_TRANSMITIR].rate;
+    printf("#RELOJ t=%lu us=%lu tx=%ld..%ld/%lu fase=%lu perdidas=%lu\r\n",
+           Timebase_Now(),Timebase_Us(),r->jitter.min,r->jitter.max,r->jitter.retraso,Rate_Fase(r),r->perdidas);
+    //Registro en flash: filas escritas / arranque / peor escritura de fila en ticks
+    printf("#LOG filas=%lu arranque=%u escritura=%lu\r\n",
+           Registro_Filas(),Registro_Arranque(),Registro_PeorEscritura());
+    //Respaldo de la energia: guardados / cortes detectados / tiempo total en s
+    printf("#RESPALDO n=%lu cortes=%lu tiempo=%lu\r\n",
+           Respaldo_Escrituras(),Respaldo_Cortes(),Respaldo_Tiempo());
+    if(Ahorro_Estado()!=AHORRO_APAGADO){
+        Imprimir_Ahorro();
+    }
+    //Pulsos del ultimo segundo: periodos completos, frecuencia, ciclo de trabajo,
+    //promedios de ancho y periodo, pico, energia por pulso y por periodo, umbrales
+    printf("#PULSOS n=%lu f=%lu.%03lu Hz duty=%lu.%lu%% ancho=%lu us periodo=%lu us pico=%ld mA"
+           " e_pulso=%ld uJ e_periodo=%ld uJ umbral=%ld/%ld mA\r\n",
+           rp->n,rp->f_mhz/1000u,rp->f_mhz%1000u,rp->duty_permil/10u,rp->duty_permil%10u,rp->ancho_us,rp->periodo_us,
+           rp->pico_ua/1000,rp->e_pulso_uj,rp->e_periodo_uj,rp->alto_ua/1000,rp->bajo_ua/1000);
+    //Bateria: estado de carga, carga restante, contadores de carga y descarga,
+    //corriente promediada, tiempo hasta vacio / lleno (-1 = no aplica) y origen
+    //de la ultima resincronizacion
+    if(Bateria_Activa()){
+        Bateria_Leer(&be);
+        printf("#BATERIA soc=%u.%u%% restante=%ld uAh carga=%ld uAh descarga=%ld uAh i=%ld uA"
+               " vacio=%ld s lleno=%ld s sincro=%s hace=%lu s\r\n",
+               be.soc_permil/10u,be.soc_permil%10u,be.restante_uah,be.carga_uah,be.descarga_uah,
+               be.i_prom_ua,be.vacio_s,be.lleno_s,Bateria_Sincro(be.sincro),be.sincro_s);
+    }
+    //Eficiencia: pares del ultimo segundo, eficiencia de la ventana, ultima
+    //instantanea y su rango (por mil, -1 sin entrada), potencias promedio y sesgo
+    //entre los disparos de los dos sensores min/prom/max
+    if(Adquisicion_Dual()){
+        printf("#EFICIENCIA n=%lu ef=%ld inst=%ld (%ld..%ld) pin=%ld mW pout=%ld mW perdida=%ld mW sesgo=%lu/%lu/%lu us\r\n",
+               ef->n,ef->ef_permil,ef->inst_permil,ef->inst_min,ef->inst_max,ef->pin_mw,ef->pout_mw,ef->perdida_mw,
+               ef->sesgo_min_us,ef->sesgo_prom_us,ef->sesgo_max_us);
+    }
+    //Filtros: salidas decimadas y ciclos por muestra de entrada, promedio / peor
+    printf("#FILTRO salidas=%lu ciclos=%lu/%lu\r\n",filtro_salidas,
+           (filtro_entradas!=0u) ? (filtro_ciclos/filtro_entradas) : 0u,filtro_peor);
+    //Alarmas: activas (bit 0 I, 1 V, 2 P) / disparos / latencia del ultimo y del
+    //peor disparo, desde la interrupcion de la lectura hasta el pin
+    printf("#ALARMAS activas=0x%02X disparos=%lu latencia=%lu/%lu us\r\n",
+           Alarma_Activas(),Alarma_Disparos(),Alarma_Latencia_us(),Alarma_PeorLatencia_us());
+    //Gobernador del bus: reloj promedio y energia estimada del nucleo por muestra
+    //en el ultimo segundo, y cambios de reloj
+    printf("#ESCALA on=%u reloj=%lu kHz energia=%lu uJ/muestra cambios=%lu\r\n",
+           Escala_Habilitado(),Escala_Promedio_kHz(),Escala_Energia_uJ(muestras_ant),Escala_Cambios());
+    //Watchdog: reinicios desde el encendido y segundos con datos en por mil
+    printf("#VIGIA wdt=%lu disponible=%lu\r\n",Vigia_Reinicios(),Vigia_Disponibilidad_Permil());
+}
+
+//Bajo consumo: ciclos de Sleep / fraccion despierto en por mil / peor
+//reposicion al despertar en us / periodo del CTW medido en ms
+static void Imprimir_Ahorro(void){
+    printf("#AHORRO ciclos=%lu activo=%lu despertar=%lu periodo=%lu\r\n",
+           Ahorro_Ciclos(),Ahorro_Ciclo_Permil(),Ahorro_Despertar_us(),Ahorro_Periodo_ms());
+}
+
+//Cierre del segundo de los diagnosticos: mide las tasas, corta los intervalos de
+//pulsos y eficiencia y reinicia los contadores aunque no se mande nada. Las lineas
+//salen solo si el PC las pide con 'r' (una vez por pedido), porque a 9600 baud
+//ocupan ~650 bytes, mas de medio segundo de linea. En bajo consumo el PSoC no
+//duerme hasta vaciar la consola, asi que mientras cicla solo sale #AHORRO.
+void Reportar_Tasas(){
+    static uint32 idle_ant=0;
+    uint32 idle=Sched_IdleCount();
+    Pulso_Resumen rp;
+    Eficiencia_Resumen ef;
+    uint8 k;
+    
+    for(k=0;k<N_TAREAS;k++){
+        Rate_Measure(&tareas[k].rate);
+    }
+    Pulso_Intervalo(&pulsos,&rp);
+    if(Adquisicion_Dual()){
+        Eficiencia_Cerrar(&ef);
+    }
+    if(pedir_tasas && (UART_Volcando()==0u)){
+        pedir_tasas=0;
+        if(Ahorro_Estado()==AHORRO_CICLANDO){
+            Imprimir_Ahorro();
+        }else{
+            Imprimir_Tasas(idle-idle_ant,&rp,&ef);
+        }
+    }
+    idle_ant=idle;
+    filtro_salidas=0;
+    filtro_ciclos=0;
+    filtro_entradas=0;
+    filtro_peor=0;
+    Escala_Reset();
 }
 
 int main(void)
 {
     CyGlobalIntEnable; /* Enable global interrupts. */
-    //isr_Rx_StartEx(Rx);
-    isr_timer_StartEx(timer);
     /* Place your initialization/startup code here (e.g. MyInst_Start()) */
-    LCD_Start();
+    //Primero lo que hace falta para la primera muestra (base de tiempo, INA219 y
+    //UART); la LCD, que necesita ~70 ms de esperas, se inicializa desde Idle()
+    Perfil_Dwt();
+    Perfil_Start();
+    Timebase_Start();
     I2C_Start();
     UART_Start();
-    timer_Start();
-    LCD_Position(0,5);
-  //  LCD_PrintString("jej");
+    origen_config=Config_Init();
+    Registro_Start();
+    Histograma_Restaurar(Registro_Histograma());
+    origen_respaldo=Respaldo_Init();
+    totales.energia_mwms=Respaldo_Get()->energia_mwms;
+    Sched_Init(tareas,N_TAREAS,Idle);
+    Escala_Start();
+    Escala_Habilitar(1u);
+    Sched_SetDespacho(Despachar);
+    Vigia_Start(Tareas_Periodicas());
+    Alarma_Start(T_ALARMA);
+    Pulso_Iniciar(&pulsos,0);
+    Aplicar_Config();
+    Adquisicion_Start(Config_Get()->muestreo_hz,Config_Get()->ina_config,T_PROCESAR);
+    Timebase_SetHook(Tick);
+    isr_Rx_StartEx(Rx);
+    Display_Start();
     
     for(;;)
     {
         /* Place your application code here. */
-        
-        //LECTURA DE UN SOLO BYTE DEL SENSOR
-        
-        do
-        {
-       I2C_MasterSendStart(SlaveAddress,I2C_WRITE_XFER_MODE);
-        
-        }
-        while(result!=I2C_MSTR_NO_ERROR);   
-            
-            Get_voltage_shunt(SlaveAddress,0x01);            
-            Get_voltage_bus(SlaveAddress,0x02);
-         
-            //Get_Corriente();
-            //Get_Potencia();
-            I2C_MasterSendStop();
-            
-                I2C_MasterSendRestart(SlaveAddress, I2C_WRITE_XFER_MODE);
-            I2C_MasterWriteByte(0x00);
-            I2C_MasterWriteByte(0xAB);
-            I2C_MasterWriteByte(0x3F);
-                       
-            factor_lsb_Corriente=(3/32768);
-            float cor=(voltaje_shunt*4473)/4096;
-            float factor_lsb_potencia=factor_lsb_Corriente*20;
-            pot=factor_lsb_potencia*(cor*vbus)/5000;
-              
-        LCD_Position(0,0);
-        LCD_PrintString("Vs:");
-        LCD_Position(0,3);
-        LCD_PrintHexUint16(voltaje_shunt);
-        
-        LCD_Position(0,9);
-        LCD_PrintString("I:");
-        LCD_Position(0,11);
-        LCD_PrintHexUint16(cor);
-        
-        
-        LCD_Position(1,0);
-        LCD_PrintString("Vb:");
-        LCD_Position(1,3);
-        LCD_PrintHexUint16(vbus);
-        
-        LCD_Position(1,10);
-        LCD_PrintString("P:");
-        LCD_Position(1,12);
-        LCD_PrintHexUint16(pot);  
-       // uint16 base=1;
-        char Value[6]="";
-        pot=74.4;
-        //aqui va el codigo
-        //miro la condicion de magnitud
-        if(pot*pot<1){
-        sprintf(Value,"%.5f",pot);
-        }else{
-        sprintf(Value,"%.2f",pot); 
-        }
-      ///defini previamente la estructura del envio 
-        LCD_Position(1,9);
-        LCD_PutChar(Value[2]);
-        char *temp="";
-        sprintf(temp, "%lu",time);
-        strcat(temp,"\t");
-        strcat(temp,Value);
-       // printf("%lu\t", time);
-        printf("%s\r\n", temp);
-       // for(int j=0;j<6;j++){
-       // UART_PutChar(Value[j]);
-       // }
-       //  UART_PutString(Value);
-   
-      ///  printf("Hola a todos");
-        //printf("%f",pot);
-       // printf("\n");
-        
+        //Cada tarea corre a su propia cadencia hasta terminar; el peor caso del
+        //lazo es la tarea mas larga, no la suma de todas
+        Sched_Run();
     }
 }
 
@@ -0,0 +1,132 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "medicion.h"
+#include "sensor.h"
+
+#define MWMS_POR_MWH    3600000
+
+static int32 rshunt_mohm = RSHUNT_MOHM;
+static int32 ganancia_ppm = 0;
+static int32 offset_ua = 0;
+
+//Calibracion de la corriente: shunt real y correccion de ganancia/offset
+void Medicion_Calibrar(uint16 rshunt, int32 ganancia, int32 offset){
+    rshunt_mohm=(rshunt!=0u) ? (int32)rshunt : RSHUNT_MOHM;
+    ganancia_ppm=ganancia;
+    offset_ua=offset;
+}
+
+//shunt_raw: registro 0x01 (complemento a 2; escala segun el sensor, ver sensor.h)
+//bus_raw:   registro 0x02 ya pasado por Sensor_Bus()
+EN_RAM void Medicion_Convertir(uint16 shunt_raw, uint16 bus_raw, uint32 t_ms, uint32 t_us, Muestra *m){
+    m->t_ms=t_ms;
+    m->t_us=t_us;
+    m->vbus_mv=Sensor_Bus_mv(bus_raw);
+    m->corriente_ua=Sensor_Corriente_ua((int16)shunt_raw,rshunt_mohm);
+    if(ganancia_ppm!=0){
+        m->corriente_ua+=(int32)(((int64)m->corriente_ua*ganancia_ppm)/1000000);
+    }
+    m->corriente_ua+=offset_ua;
+    m->potencia_mw=(int32)(((int64)m->vbus_mv*m->corriente_ua)/1000000);
+}
+
+EN_RAM void Ventana_Agregar(Ventana *v, const Muestra *m){
+    if(v->n==0u){
+        v->min_mw=m->potencia_mw;
+        v->max_mw=m->potencia_mw;
+    }
+    v->suma_mv+=m->vbus_mv;
+    v->suma_ua+=m->corriente_ua;
+    v->suma_mw+=m->potencia_mw;
+    if(m->potencia_mw<v->min_mw){
+        v->min_mw=m->potencia_mw;
+    }
+    if(m->potencia_mw>v->max_mw){
+        v->max_mw=m->potencia_mw;
+    }
+    v->n++;
+}
+
+//Devuelve 0 si la ventana estaba vacia (el resumen anterior queda intacto)
+uint8 Ventana_Cerrar(Ventana *v, Resumen *r){
+    if(v->n==0u){
+        return 0u;
+    }
+    r->vbus_mv=(uint16)(v->suma_mv/v->n);
+    r->corriente_ua=(int32)(v->suma_ua/v->n);
+    r->potencia_mw=(int32)(v->suma_mw/v->n);
+    r->pmin_mw=v->min_mw;
+    r->pmax_mw=v->max_mw;
+    r->n=v->n;
+    v->suma_mv=0;
+    v->suma_ua=0;
+    v->suma_mw=0;
+    v->n=0u;
+    return 1u;
+}
+
+//Integracion trapezoidal de la potencia entre muestras consecutivas, con el
+//intervalo en us: el jitter del tick de 1 ms ya no entra en la energia
+EN_RAM void Totales_Integrar(Totales *t, const Muestra *m){
+    if(t->hay_anterior){
+        uint32 dt=m->t_us-t->t_ant_us;
+        int64 e=(((int64)(t->p_ant_mw+m->potencia_mw)*dt)/2)+t->resto_mwus;
+        t->energia_mwms+=e/1000;
+        t->resto_mwus=(int32)(e%1000);
+    }
+    t->t_ant_us=m->t_us;
+    t->p_ant_mw=m->potencia_mw;
+    t->hay_anterior=1u;
+}
+
+int32 Totales_Energia_mWh(const Totales *t){
+    return (int32)(t->energia_mwms/MWMS_POR_MWH);
+}
+
+//Escribe milis/1000 con el numero de decimales pedido (0 a 3, truncado).
+//No usa printf de punto flotante. Devuelve la cantidad de caracteres escritos.
+uint8 Medicion_Formato(char *dst, int32 milis, uint8 decimales){
+    char tmp[10];
+    uint8 n=0,k=0,i;
+    uint32 mag,ent,frac;
+
+    if(milis<0){
+        dst[n++]='-';
+        mag=(uint32)(-milis);
+    }else{
+        mag=(uint32)milis;
+    }
+    ent=mag/1000u;
+    frac=mag%1000u;
+    do{
+        tmp[k++]=(char)('0'+(ent%10u));
+        ent/=10u;
+    }while(ent!=0u);
+    while(k>0u){
+        dst[n++]=tmp[--k];
+    }
+    if(decimales>3u){
+        decimales=3u;
+    }
+    if(decimales>0u){
+        dst[n++]='.';
+        for(i=0;i<decimales;i++){
+            frac*=10u;
+            dst[n++]=(char)('0'+(frac/1000u));
+            frac%=1000u;
+        }
+    }
+    dst[n]='\0';
+    return n;
+}
+
+/* [] END OF FILE */
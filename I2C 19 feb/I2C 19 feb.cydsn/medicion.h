@@ -0,0 +1,74 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef MEDICION_H
+#define MEDICION_H
+
+#include "project.h"
+#include "ramfunc.h"
+
+//Resistencia shunt del modulo en miliohms (el INA260 la trae adentro y no la usa) (valor por defecto; el que se
+//usa sale de la configuracion guardada, ver Medicion_Calibrar)
+#define RSHUNT_MOHM         100
+
+//Una muestra ya convertida a unidades fisicas (aritmetica entera)
+typedef struct
+{
+    uint32 t_ms;            //instante de la muestra
+    uint32 t_us;            //el mismo en us (Timebase_Us), para integrar y medir pulsos
+    uint16 vbus_mv;         //voltaje del bus
+    int32  corriente_ua;    //corriente con signo (negativa = sentido inverso)
+    int32  potencia_mw;     //potencia con signo
+} Muestra;
+
+//Acumuladores de una ventana de estadistica
+typedef struct
+{
+    int64  suma_mv;
+    int64  suma_ua;
+    int64  suma_mw;
+    int32  min_mw;
+    int32  max_mw;
+    uint16 n;
+} Ventana;
+
+//Resultado de cerrar una ventana
+typedef struct
+{
+    uint16 vbus_mv;
+    int32  corriente_ua;
+    int32  potencia_mw;
+    int32  pmin_mw;
+    int32  pmax_mw;
+    uint16 n;
+} Resumen;
+
+//Totales desde el arranque
+typedef struct
+{
+    int64  energia_mwms;    //energia en mW*ms (1 mWh = 3 600 000 mW*ms)
+    int32  resto_mwus;      //fraccion de mW*ms que todavia no paso a energia_mwms, en mW*us
+    uint32 t_ant_us;        //instante de la muestra anterior, para integrar
+    int32  p_ant_mw;
+    uint8  hay_anterior;
+} Totales;
+
+void   Medicion_Calibrar(uint16 rshunt_mohm, int32 ganancia_ppm, int32 offset_ua);
+//Camino de cada muestra: corre desde SRAM
+EN_RAM void Medicion_Convertir(uint16 shunt_raw, uint16 bus_raw, uint32 t_ms, uint32 t_us, Muestra *m);
+EN_RAM void Ventana_Agregar(Ventana *v, const Muestra *m);
+uint8  Ventana_Cerrar(Ventana *v, Resumen *r);
+EN_RAM void Totales_Integrar(Totales *t, const Muestra *m);
+int32  Totales_Energia_mWh(const Totales *t);
+uint8  Medicion_Formato(char *dst, int32 milis, uint8 decimales);
+
+#endif /* MEDICION_H */
+/* [] END OF FILE */
@@ -0,0 +1,116 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#if defined(PERFIL_HOST) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 199309L     //clock_gettime con -std=c99
+#endif
+#include "perfil.h"
+
+#if !defined(PERFIL_HOST)
+
+//Habilita el bloque de traza y arranca el contador de ciclos del DWT. Lo usan
+//tambien la adquisicion, el bajo consumo, el watchdog y las alarmas aunque el
+//perfilado este apagado; main lo llama una vez al arrancar.
+void Perfil_Dwt(void){
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+#endif
+
+#if (PERFIL_HABILITADO != 0)
+
+#include <stdio.h>
+#if defined(PERFIL_HOST)
+    #include <time.h>
+#endif
+
+static const char * const nombres[PF_REGIONES] = {
+    "i2c", "conv", "fmt", "lcd", "uart", "isr_tmr", "isr_i2c", "isr_rx"
+};
+
+Perfil_Region perfil[PF_REGIONES];
+
+#if defined(PERFIL_HOST)
+
+uint32 Perfil_Ciclos(void){
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32)((uint64)ts.tv_sec * 1000000000u + (uint64)ts.tv_nsec);
+}
+
+#endif
+
+//El contador del DWT ya corre (Perfil_Dwt)
+void Perfil_Start(void){
+    Perfil_Reset();
+}
+
+//Las regiones de ISR tambien pasan por aca; todas las interrupciones que se
+//miden tienen la misma prioridad, asi que basta con que la tarea no se interrumpa
+//a mitad de una actualizacion.
+void Perfil_Registrar(uint8 id, uint32 duracion){
+    Perfil_Region *r;
+    uint8 estado;
+
+    if(id >= PF_REGIONES){
+        return;
+    }
+    r = &perfil[id];
+#if defined(PERFIL_HOST)
+    estado = 0u;
+#else
+    estado = CyEnterCriticalSection();
+#endif
+    if((r->n == 0u) || (duracion < r->min)){
+        r->min = duracion;
+    }
+    if(duracion > r->max){
+        r->max = duracion;
+    }
+    r->total += duracion;
+    r->n++;
+#if defined(PERFIL_HOST)
+    (void)estado;
+#else
+    CyExitCriticalSection(estado);
+#endif
+}
+
+void Perfil_Reset(void){
+    uint8 i;
+
+    for(i = 0u; i < PF_REGIONES; i++){
+        perfil[i].n = 0u;
+        perfil[i].min = 0u;
+        perfil[i].max = 0u;
+        perfil[i].total = 0u;
+    }
+}
+
+//Una linea por region: cantidad, minimo, promedio y maximo
+void Perfil_Dump(void){
+    uint8 i;
+
+    printf("#PERFIL %s %s\r\n", PERFIL_BUILD, PERFIL_UNIDAD);
+    for(i = 0u; i < PF_REGIONES; i++){
+        const Perfil_Region *r = &perfil[i];
+        uint32 prom = (r->n != 0u) ? (uint32)(r->total / r->n) : 0u;
+
+        printf("%s\tn=%lu min=%lu prom=%lu max=%lu\r\n", nombres[i],
+               (unsigned long)r->n, (unsigned long)r->min, (unsigned long)prom, (unsigned long)r->max);
+    }
+}
+
+#endif
+
+/* [] END OF FILE */
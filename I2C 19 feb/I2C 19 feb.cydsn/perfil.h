@@ -0,0 +1,103 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef PERFIL_H
+#define PERFIL_H
+
+//Perfilado de regiones con nombre. En el PSoC se cuentan ciclos con el DWT CYCCNT
+//del Cortex-M3; compilando para el PC con -DPERFIL_HOST se usan nanosegundos de
+//clock_gettime. Por defecto solo esta activo en Debug: en Release (NDEBUG) las
+//macros no generan codigo, salvo que se compile con PERFIL_HABILITADO=1 para
+//comparar ciclos entre configuraciones (ver comparar_builds.py).
+#if defined(PERFIL_HOST)
+    #include <stdint.h>
+    typedef uint8_t  uint8;
+    typedef uint32_t uint32;
+    typedef uint64_t uint64;
+    #define PERFIL_UNIDAD   "ns"
+#else
+    #include "project.h"
+    #define PERFIL_UNIDAD   "ciclos"
+#endif
+
+#if defined(NDEBUG)
+    #define PERFIL_BUILD    "Release"
+#else
+    #define PERFIL_BUILD    "Debug"
+#endif
+
+#if !defined(PERFIL_HABILITADO)
+    #if defined(DEBUG) || defined(PERFIL_HOST)
+        #define PERFIL_HABILITADO   1
+    #else
+        #define PERFIL_HABILITADO   0
+    #endif
+#endif
+
+//Regiones medidas
+enum
+{
+    PF_I2C = 0u,        //muestra completa del INA219 (2 registros por interrupciones)
+    PF_CONVERSION,      //crudo -> unidades, ventana y energia
+    PF_FORMATO,         //formateo de punto fijo del reporte
+    PF_LCD,             //volcado de los caracteres cambiados a la LCD
+    PF_UART,            //encolado del reporte en la UART
+    PF_ISR_TIMER,       //isr_timer
+    PF_ISR_I2C,         //parte propia de I2C_ISR (I2C_ISR_ExitCallback)
+    PF_ISR_RX,          //isr_Rx
+    PF_REGIONES
+};
+
+typedef struct
+{
+    uint32 inicio;      //marca de PERFIL_INICIO en curso
+    uint32 n;
+    uint32 min;
+    uint32 max;
+    uint64 total;
+} Perfil_Region;
+
+#if !defined(PERFIL_HOST)
+    void Perfil_Dwt(void);
+#endif
+
+#if (PERFIL_HABILITADO != 0)
+
+extern Perfil_Region perfil[PF_REGIONES];
+
+void   Perfil_Start(void);
+void   Perfil_Registrar(uint8 id, uint32 duracion);
+void   Perfil_Reset(void);
+void   Perfil_Dump(void);
+
+#if defined(PERFIL_HOST)
+    uint32 Perfil_Ciclos(void);
+#else
+    #define Perfil_Ciclos()     (DWT->CYCCNT)
+#endif
+
+//Una region no se anida consigo misma; inicio y fin pueden estar en funciones
+//distintas (por ejemplo una transaccion que termina en otra interrupcion)
+#define PERFIL_INICIO(id)   (perfil[(id)].inicio = Perfil_Ciclos())
+#define PERFIL_FIN(id)      Perfil_Registrar((uint8)(id), Perfil_Ciclos() - perfil[(id)].inicio)
+
+#else
+
+#define Perfil_Start()      ((void)0)
+#define Perfil_Reset()      ((void)0)
+#define Perfil_Dump()       ((void)0)
+#define PERFIL_INICIO(id)   ((void)0)
+#define PERFIL_FIN(id)      ((void)0)
+
+#endif
+
+#endif /* PERFIL_H */
+/* [] END OF FILE */
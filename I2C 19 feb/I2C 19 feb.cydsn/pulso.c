@@ -0,0 +1,142 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "pulso.h"
+
+#define SIN_UMBRAL      0x7FFFFFFF
+
+static void Umbral_Manual(Pulso *p){
+    p->alto_ua=p->umbral_ua;
+    p->bajo_ua=(int32)(((int64)p->umbral_ua*(100-PULSO_HISTERESIS_PCT))/100);
+}
+
+void Pulso_Iniciar(Pulso *p, int32 umbral_ma){
+    p->umbral_ua=umbral_ma*1000;
+    if(p->umbral_ua>0){
+        Umbral_Manual(p);
+    }else{
+        p->umbral_ua=0;
+        p->alto_ua=SIN_UMBRAL;  //el automatico espera un intervalo para tener rango
+        p->bajo_ua=SIN_UMBRAL;
+    }
+    p->encendido=0u;
+    p->hay_subida=0u;
+    p->hay_anterior=0u;
+    p->hay_rango=0u;
+    p->n=0u;
+    p->suma_periodo=0u;
+    p->suma_ancho=0u;
+    p->suma_e_pulso=0;
+    p->suma_e_periodo=0;
+    p->pico_max=0;
+}
+
+//Una muestra: energia del tramo desde la anterior, flancos y pico. Cada muestra
+//representa el tramo que termina en ella, asi que la de subida ya es del pulso
+//nuevo y la de bajada ya no es del pulso.
+void Pulso_Agregar(Pulso *p, const Muestra *m){
+    int32 i=m->corriente_ua;
+    int64 e=0;
+
+    if(p->hay_anterior!=0u){
+        e=(int64)m->potencia_mw*(int32)(m->t_us-p->t_anterior);
+    }
+    p->t_anterior=m->t_us;
+    p->hay_anterior=1u;
+    if(p->hay_rango==0u){
+        p->hay_rango=1u;
+        p->min_ua=i;
+        p->max_ua=i;
+    }else if(i<p->min_ua){
+        p->min_ua=i;
+    }else if(i>p->max_ua){
+        p->max_ua=i;
+    }
+    p->e_periodo+=e;
+    if(p->encendido!=0u){
+        if(i<=p->bajo_ua){
+            p->encendido=0u;
+            p->t_bajada=m->t_us;
+            return;
+        }
+        p->e_pulso+=e;
+        if(i>p->pico_ua){
+            p->pico_ua=i;
+        }
+        return;
+    }
+    if(i<p->alto_ua){
+        return;
+    }
+    //flanco de subida: cierra el periodo anterior (si hubo un pulso completo)
+    if((p->hay_subida!=0u) && (p->t_bajada!=p->t_subida)){
+        p->n++;
+        p->suma_periodo+=m->t_us-p->t_subida;
+        p->suma_ancho+=p->t_bajada-p->t_subida;
+        p->suma_e_pulso+=p->e_pulso;
+        p->suma_e_periodo+=p->e_periodo-e;
+        if(p->pico_ua>p->pico_max){
+            p->pico_max=p->pico_ua;
+        }
+    }
+    p->hay_subida=1u;
+    p->encendido=1u;
+    p->t_subida=m->t_us;
+    p->t_bajada=m->t_us;
+    p->pico_ua=i;
+    p->e_pulso=e;
+    p->e_periodo=e;
+}
+
+//Promedios de los periodos cerrados en el intervalo; recalcula el umbral automatico
+void Pulso_Intervalo(Pulso *p, Pulso_Resumen *r){
+    r->n=p->n;
+    if(p->n!=0u){
+        r->periodo_us=p->suma_periodo/p->n;
+        r->ancho_us=p->suma_ancho/p->n;
+        r->f_mhz=(p->suma_periodo!=0u) ? (uint32)(((uint64)p->n*1000000000u)/p->suma_periodo) : 0u;
+        r->duty_permil=(p->suma_periodo!=0u) ? (uint32)(((uint64)p->suma_ancho*1000u)/p->suma_periodo) : 0u;
+        r->e_pulso_uj=(int32)((p->suma_e_pulso/(int64)p->n)/1000);
+        r->e_periodo_uj=(int32)((p->suma_e_periodo/(int64)p->n)/1000);
+    }else{
+        r->periodo_us=0u;
+        r->ancho_us=0u;
+        r->f_mhz=0u;
+        r->duty_permil=0u;
+        r->e_pulso_uj=0;
+        r->e_periodo_uj=0;
+    }
+    r->pico_ua=p->pico_max;
+    r->alto_ua=(p->alto_ua!=SIN_UMBRAL) ? p->alto_ua : 0;
+    r->bajo_ua=(p->bajo_ua!=SIN_UMBRAL) ? p->bajo_ua : 0;
+    p->n=0u;
+    p->suma_periodo=0u;
+    p->suma_ancho=0u;
+    p->suma_e_pulso=0;
+    p->suma_e_periodo=0;
+    p->pico_max=0;
+    if((p->umbral_ua==0) && (p->hay_rango!=0u)){
+        int32 rango=p->max_ua-p->min_ua;
+
+        if(rango>=PULSO_RANGO_MIN_UA){
+            p->alto_ua=p->min_ua+(rango/8)*5;
+            p->bajo_ua=p->min_ua+(rango/8)*3;
+        }else{
+            p->alto_ua=SIN_UMBRAL;
+            p->bajo_ua=SIN_UMBRAL;
+            p->encendido=0u;
+            p->hay_subida=0u;
+        }
+    }
+    p->hay_rango=0u;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,78 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef PULSO_H
+#define PULSO_H
+
+#include "project.h"
+#include "medicion.h"
+
+//Analizador de cargas pulsadas (PWM, rafagas de radio, motores) sobre el flujo
+//de muestras de corriente, incremental y con memoria fija por canal. Detecta
+//flancos con histeresis: enciende al pasar "alto" y apaga al bajar de "bajo".
+//Por cada periodo completo (subida a subida) acumula periodo, ancho, corriente
+//pico, energia del pulso y energia del periodo; cada intervalo de reporte se
+//entregan los promedios y se vuelve a empezar.
+//Los instantes son los de Timebase_Us: anchos y periodos en us y energias en
+//nJ (mW x us), aunque la muestra siga llegando en la grilla del tick de 1 ms.
+//Umbral manual en mA (bajo = 90 % del alto) o automatico (0): 5/8 y 3/8 del
+//rango min..max de corriente del intervalo anterior, si el rango supera
+//PULSO_RANGO_MIN_UA. La resolucion en tiempo es la del muestreo (Cmu=, hasta
+//1 kHz): los pulsos mas cortos que un periodo de muestreo se pierden o se alias.
+#define PULSO_HISTERESIS_PCT    10
+#define PULSO_RANGO_MIN_UA      2000    //por debajo la carga se considera constante
+
+typedef struct
+{
+    uint32 n;               //periodos completos
+    uint32 periodo_us;      //promedios
+    uint32 ancho_us;
+    uint32 f_mhz;           //frecuencia en mHz
+    uint32 duty_permil;
+    int32  pico_ua;         //maximo del intervalo
+    int32  e_pulso_uj;      //promedio por pulso
+    int32  e_periodo_uj;    //promedio por periodo
+    int32  alto_ua;         //umbrales en uso (0 si la carga es constante y no se buscan pulsos)
+    int32  bajo_ua;
+} Pulso_Resumen;
+
+typedef struct
+{
+    int32  umbral_ua;       //0 = automatico
+    int32  alto_ua;
+    int32  bajo_ua;
+    uint8  encendido;
+    uint8  hay_subida;      //ya hubo un flanco de subida (hay un periodo abierto)
+    uint8  hay_anterior;
+    uint32 t_anterior;
+    uint32 t_subida;
+    uint32 t_bajada;
+    int32  pico_ua;         //del pulso en curso
+    int64  e_pulso;         //nJ (mW x us) del pulso en curso
+    int64  e_periodo;       //nJ desde la ultima subida
+    int32  min_ua;          //rango del intervalo, para el umbral automatico
+    int32  max_ua;
+    uint8  hay_rango;
+    //acumulado del intervalo
+    uint32 n;
+    uint32 suma_periodo;
+    uint32 suma_ancho;
+    int64  suma_e_pulso;
+    int64  suma_e_periodo;
+    int32  pico_max;
+} Pulso;
+
+void Pulso_Iniciar(Pulso *p, int32 umbral_ma);
+void Pulso_Agregar(Pulso *p, const Muestra *m);
+void Pulso_Intervalo(Pulso *p, Pulso_Resumen *r);
+
+#endif /* PULSO_H */
+/* [] END OF FILE */
@@ -0,0 +1,35 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef RAMFUNC_H
+#define RAMFUNC_H
+
+//Funciones que se ejecutan desde SRAM. cm3gcc.ld ya reserva la seccion de entrada
+//".ram" dentro de .data (>ram AT>rom), asi que Cm3Start la copia desde la flash
+//junto con las variables inicializadas y no hay que tocar el linker script, que
+//PSoC Creator regenera en cada build. La SRAM baja (0x1FFF8000) esta en el bus de
+//codigo y no tiene estados de espera, a diferencia de la flash a 24 MHz.
+//long_call porque la SRAM queda fuera del alcance de un BL desde la flash.
+//Compilando con EN_RAM_HABILITADO=0 todo vuelve a la flash, para comparar.
+#if !defined(EN_RAM_HABILITADO)
+    #define EN_RAM_HABILITADO   1
+#endif
+
+#if (EN_RAM_HABILITADO != 0) && defined(__GNUC__)
+    #define EN_RAM              __attribute__((section(".ram"), long_call, noinline))
+    #define EN_RAM_LUGAR        "ram"
+#else
+    #define EN_RAM
+    #define EN_RAM_LUGAR        "flash"
+#endif
+
+#endif /* RAMFUNC_H */
+/* [] END OF FILE */
@@ -0,0 +1,380 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "registro.h"
+#include "config.h"
+#include "timebase.h"
+#include "histograma.h"
+#include "consola.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+//El anillo va al final del ultimo arreglo de flash, lejos del codigo (arreglo 0):
+//mientras el SPC programa ese arreglo las ISR, que corren desde SRAM, y la
+//lectura de instrucciones del arreglo 0 siguen sin esperar.
+#define LOG_ARREGLO         ((uint8)(CY_FLASH_NUMBER_ARRAYS - 1u))
+#define FILAS_ARREGLO       (CY_FLASH_SIZEOF_ARRAY / CY_FLASH_SIZEOF_ROW)
+#define LOG_FILA0           ((uint16)(FILAS_ARREGLO - LOG_FILAS))
+#define LOG_BASE            (CY_FLASH_BASE + ((uint32)LOG_ARREGLO * CY_FLASH_SIZEOF_ARRAY) + \
+                             ((uint32)LOG_FILA0 * CY_FLASH_SIZEOF_ROW))
+
+#define VOLCADO_TROZO       32u     //bytes maximos por llamada a Registro_Volcar_Poll
+#define TEMP_CADA           16u     //filas entre mediciones de temperatura del SPC
+
+//CyWriteRowData escribe la fila entera desde el buffer: tiene que medir justo una fila
+typedef char log_fila_completa[(sizeof(Log_Fila) == CY_FLASH_SIZEOF_ROW) ? 1 : -1];
+typedef char log_histograma_completa[(sizeof(Log_Histograma) == CY_FLASH_SIZEOF_ROW) ? 1 : -1];
+
+//Fin de la imagen en flash (.data va despues de .rodata), ver cm3gcc.ld
+extern const uint32 __cy_regions[];
+
+enum
+{
+    PASO_ESPERA = 0u,       //juntando resumenes
+    PASO_TEMPERATURA,       //fila llena: medir temperatura para el SPC
+    PASO_ESCRIBIR           //fila llena: escribir
+};
+
+static Log_Fila fila;                   //fila en preparacion
+static uint8    paso = PASO_ESPERA;
+static uint8    habilitado;
+static uint16   siguiente;              //indice 0..LOG_FILAS-1 de la proxima fila
+static uint32   secuencia;
+static uint16   arranque;
+static uint32   filas_escritas;
+static uint32   peor_escritura;
+static uint16   desde_temp = TEMP_CADA;
+static uint16   desde_hist;             //filas de resumenes desde el ultimo histograma
+static uint8    hist_pendiente;
+static uint16   hist_guardado = 0xFFFFu;    //fila con el histograma mas nuevo
+
+//Las dos clases de fila se escriben y verifican por el mismo camino
+typedef union
+{
+    Log_Fila       f;
+    Log_Histograma h;
+} Fila_Hist;
+static Fila_Hist hist;
+
+//Acumulador del intervalo
+static Log_Resumen acum;
+static int64    suma_mv, suma_ua, suma_mw;
+
+//Estado del volcado
+static uint8    volcando;
+static uint16   volcar_fila;            //filas que faltan
+static uint16   volcar_idx;
+static uint16   volcar_byte;
+static uint8    volcar_ram;             //falta mandar la fila en preparacion
+static Log_Fila copia_ram;
+
+static const Log_Fila *Fila_Flash(uint16 idx){
+    return (const Log_Fila *)(LOG_BASE + ((uint32)idx * CY_FLASH_SIZEOF_ROW));
+}
+
+static uint16 Crc_Fila(const Log_Fila *f){
+    const uint8 *p=(const uint8 *)f;
+    uint16 crc;
+
+    crc=Crc16(p,(uint16)offsetof(Log_Encabezado,crc));
+    return Crc16_Seguir(crc,p+sizeof(Log_Encabezado),(uint16)(sizeof(Log_Fila)-sizeof(Log_Encabezado)));
+}
+
+static uint8 Fila_Valida(const Log_Fila *f){
+    if((f->enc.magia!=LOG_MAGIA) || (f->enc.version!=LOG_VERSION) || (f->enc.n>LOG_POR_FILA) ||
+       (f->enc.tipo>LOG_TIPO_HISTOGRAMA)){
+        return 0u;
+    }
+    return (f->enc.crc==Crc_Fila(f)) ? 1u : 0u;
+}
+
+//Busca la fila mas nueva mirando solo los encabezados y verifica el CRC de la
+//candidata; si esta rota (corte durante la escritura) se descarta y se busca de
+//nuevo. En el caso normal hay un solo CRC por arranque.
+void Registro_Start(void){
+    uint32 fin_imagen=__cy_regions[0]+__cy_regions[2];
+    uint8  descartada[LOG_FILAS/8u];
+    uint16 i,mejor;
+    uint8  intentos;
+
+    memset(&fila,0,sizeof(fila));
+    memset(&acum,0,sizeof(acum));
+    habilitado=(fin_imagen<=LOG_BASE) ? 1u : 0u;
+    siguiente=0u;
+    secuencia=1u;
+    arranque=1u;
+    if(habilitado==0u){
+        return;
+    }
+    CyFlash_Start();
+    memset(descartada,0,sizeof(descartada));
+    for(intentos=0;intentos<4u;intentos++){
+        mejor=0xFFFFu;
+        for(i=0;i<LOG_FILAS;i++){
+            const Log_Fila *f=Fila_Flash(i);
+            if((descartada[i>>3] & (uint8)(1u<<(i&7u)))!=0u){
+                continue;
+            }
+            if((f->enc.magia==LOG_MAGIA) &&
+               ((mejor==0xFFFFu) || ((int32)(f->enc.secuencia-Fila_Flash(mejor)->enc.secuencia)>0))){
+                mejor=i;
+            }
+        }
+        if(mejor==0xFFFFu){
+            break;
+        }
+        if(Fila_Valida(Fila_Flash(mejor))){
+            const Log_Fila *f=Fila_Flash(mejor);
+            siguiente=(uint16)((mejor+1u)%LOG_FILAS);
+            secuencia=f->enc.secuencia+1u;
+            arranque=(uint16)(f->enc.arranque+1u);
+            break;
+        }
+        descartada[mejor>>3]|=(uint8)(1u<<(mejor&7u));
+    }
+    //Histograma mas nuevo: son pocas filas, se verifica el CRC de todas
+    for(i=0;i<LOG_FILAS;i++){
+        const Log_Fila *f=Fila_Flash(i);
+        if((f->enc.magia==LOG_MAGIA) && (f->enc.tipo==LOG_TIPO_HISTOGRAMA) &&
+           ((hist_guardado==0xFFFFu) || ((int32)(f->enc.secuencia-Fila_Flash(hist_guardado)->enc.secuencia)>0)) &&
+           Fila_Valida(f)){
+            hist_guardado=i;
+        }
+    }
+}
+
+//ms por cubeta del ultimo histograma guardado, o 0 si no hay
+const uint32 *Registro_Histograma(void){
+    if(hist_guardado==0xFFFFu){
+        return 0;
+    }
+    return ((const Log_Histograma *)Fila_Flash(hist_guardado))->ms;
+}
+
+static int16 Saturar16(int64 v){
+    return (int16)((v>32767) ? 32767 : ((v<-32768) ? -32768 : v));
+}
+
+static int16 A_Cw(int32 mw){
+    return Saturar16(mw/10);
+}
+
+//Se llama con cada ventana de 1 s; cierra un resumen cada LOG_INTERVALO_S
+void Registro_Agregar(const Resumen *r, int32 energia_mwh, uint32 t_s){
+    if((habilitado==0u) || (r->n==0u)){
+        return;
+    }
+    if((acum.n==0u) || (r->pmin_mw<(int32)acum.p_min_cw*10)){
+        acum.p_min_cw=A_Cw(r->pmin_mw);
+    }
+    if((acum.n==0u) || (r->pmax_mw>(int32)acum.p_max_cw*10)){
+        acum.p_max_cw=A_Cw(r->pmax_mw);
+    }
+    suma_mv+=r->vbus_mv;
+    suma_ua+=r->corriente_ua;
+    suma_mw+=r->potencia_mw;
+    acum.n++;
+    if(acum.n<LOG_INTERVALO_S){
+        return;
+    }
+    acum.t_s=t_s;
+    acum.vbus_mv=(uint16)(suma_mv/acum.n);
+    acum.corriente_dma=Saturar16((suma_ua/acum.n)/100);   //satura en +-3.2767 A
+    acum.p_med_cw=A_Cw((int32)(suma_mw/acum.n));
+    acum.energia_mwh=energia_mwh;
+    if((paso==PASO_ESPERA) && (fila.enc.n<LOG_POR_FILA)){
+        fila.r[fila.enc.n++]=acum;
+        if(fila.enc.n>=LOG_POR_FILA){
+            paso=PASO_TEMPERATURA;
+        }
+    }
+    memset(&acum,0,sizeof(acum));
+    suma_mv=0;
+    suma_ua=0;
+    suma_mw=0;
+}
+
+//Completa el encabezado y escribe la fila en la proxima posicion del anillo
+static uint8 Escribir_Fila(Log_Fila *f, uint16 tipo){
+    uint32 t0,dur;
+    uint8 ok=0u;
+
+    f->enc.magia=LOG_MAGIA;
+    f->enc.version=LOG_VERSION;
+    f->enc.secuencia=secuencia;
+    f->enc.arranque=arranque;
+    f->enc.intervalo_s=LOG_INTERVALO_S;
+    f->enc.tipo=tipo;
+    f->enc.crc=Crc_Fila(f);
+    t0=Timebase_Now();
+    if(CyWriteRowData(LOG_ARREGLO,(uint16)(LOG_FILA0+siguiente),(const uint8 *)f)==CYRET_SUCCESS){
+        CyFlushCache();
+        if(tipo==LOG_TIPO_HISTOGRAMA){
+            hist_guardado=siguiente;
+        }else if(siguiente==hist_guardado){
+            hist_guardado=0xFFFFu;  //se piso el ultimo histograma (no pasa con LOG_HIST_CADA < LOG_FILAS)
+        }
+        siguiente=(uint16)((siguiente+1u)%LOG_FILAS);
+        secuencia++;
+        filas_escritas++;
+        desde_temp++;
+        ok=1u;
+    }
+    dur=Timebase_Now()-t0;
+    if(dur>peor_escritura){
+        peor_escritura=dur;
+    }
+    return ok;
+}
+
+//Un paso por pasada, para que ninguna pasada bloquee mas que una escritura de fila
+static void Escribir_Paso(void){
+
+    if(paso==PASO_TEMPERATURA){
+        if(desde_temp>=TEMP_CADA){
+            (void)CySetTemp();
+            desde_temp=0u;
+        }
+        paso=PASO_ESCRIBIR;
+        return;
+    }
+    if(paso!=PASO_ESCRIBIR){
+        return;
+    }
+    if(Escribir_Fila(&fila,LOG_TIPO_RESUMEN)){
+        memset(&fila,0,sizeof(fila));
+        paso=PASO_ESPERA;
+        if(++desde_hist>=LOG_HIST_CADA){
+            hist_pendiente=1u;
+        }
+    }
+}
+
+//La fila de histograma se escribe en una sola pasada, con la fila de resumenes
+//juntando (la temperatura del SPC es la de la ultima medicion)
+static void Escribir_Histograma(void){
+    memset(&hist,0,sizeof(hist));
+    Histograma_Copiar(hist.h.ms);
+    if(Escribir_Fila(&hist.f,LOG_TIPO_HISTOGRAMA)){
+        hist_pendiente=0u;
+        desde_hist=0u;
+    }
+}
+
+//Pide guardar el histograma en la proxima pasada de la tarea (por ejemplo al borrarlo)
+void Registro_Guardar_Histograma(void){
+    hist_pendiente=1u;
+}
+
+//Volcado binario: "#LOG filas=N tam=256\r\n", N filas de 256 bytes de la mas
+//vieja a la mas nueva (la ultima es la que esta en RAM), y "#FIN\r\n". Las filas
+//de histograma van mezcladas con las de resumenes; el PC las separa por enc.tipo
+void Registro_Volcar(void){
+    uint16 i,n=0;
+
+    if((habilitado==0u) || (volcando!=0u)){
+        return;
+    }
+    for(i=0;i<LOG_FILAS;i++){
+        if(Fila_Flash(i)->enc.magia==LOG_MAGIA){
+            n++;
+        }
+    }
+    copia_ram=fila;
+    copia_ram.enc.magia=LOG_MAGIA;
+    copia_ram.enc.version=LOG_VERSION;
+    copia_ram.enc.secuencia=secuencia;
+    copia_ram.enc.arranque=arranque;
+    copia_ram.enc.intervalo_s=LOG_INTERVALO_S;
+    copia_ram.enc.tipo=LOG_TIPO_RESUMEN;
+    copia_ram.enc.crc=Crc_Fila(&copia_ram);
+    volcar_ram=1u;
+    volcar_fila=LOG_FILAS;
+    volcar_idx=siguiente;
+    volcar_byte=0u;
+    volcando=1u;
+    printf("#LOG filas=%u tam=%u\r\n",(unsigned)(n+1u),(unsigned)CY_FLASH_SIZEOF_ROW);
+}
+
+//No bloquea: carga en la cola de la consola solo lo que entra (hasta VOLCADO_TROZO bytes).
+//El PC verifica el CRC de cada fila; las que tienen la magia pero no el CRC
+//(corte durante una escritura) tambien se mandan y se descartan alla.
+void Registro_Volcar_Poll(void){
+    const uint8 *p;
+    uint8 k;
+
+    if(volcando==0u){
+        return;
+    }
+    for(k=0;k<VOLCADO_TROZO;k++){
+        //salta las filas vacias
+        while((volcar_fila!=0u) && (volcar_byte==0u) &&
+              (Fila_Flash(volcar_idx)->enc.magia!=LOG_MAGIA)){
+            volcar_idx=(uint16)((volcar_idx+1u)%LOG_FILAS);
+            volcar_fila--;
+        }
+        if(volcar_fila!=0u){
+            p=(const uint8 *)Fila_Flash(volcar_idx);
+        }else if(volcar_ram!=0u){
+            p=(const uint8 *)&copia_ram;
+        }else{
+            printf("#FIN\r\n");
+            volcando=0u;
+            return;
+        }
+        if(Consola_Libre()==0u){
+            return;
+        }
+        Consola_Byte(p[volcar_byte]);
+        if(++volcar_byte>=CY_FLASH_SIZEOF_ROW){
+            volcar_byte=0u;
+            if(volcar_fila!=0u){
+                volcar_idx=(uint16)((volcar_idx+1u)%LOG_FILAS);
+                volcar_fila--;
+            }else{
+                volcar_ram=0u;
+            }
+        }
+    }
+}
+
+//Tarea periodica: avanza la escritura de la fila llena, un paso por pasada; con
+//la fila de resumenes juntando, escribe el histograma si toca
+void Registro_Tarea(void){
+    if(habilitado==0u){
+        return;
+    }
+    if(paso!=PASO_ESPERA){
+        Escribir_Paso();
+    }else if(hist_pendiente!=0u){
+        Escribir_Histograma();
+    }
+}
+
+uint8 Registro_Volcando(void){
+    return volcando;
+}
+
+//Peor tiempo de una escritura de fila, en ticks
+uint32 Registro_PeorEscritura(void){
+    return peor_escritura;
+}
+
+uint32 Registro_Filas(void){
+    return filas_escritas;
+}
+
+uint16 Registro_Arranque(void){
+    return arranque;
+}
+
+/* [] END OF FILE */
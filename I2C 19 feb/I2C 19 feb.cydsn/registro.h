@@ -0,0 +1,96 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef REGISTRO_H
+#define REGISTRO_H
+
+#include "project.h"
+#include "medicion.h"
+#include "histograma.h"
+
+//Registro de resumenes en la flash para cuando no hay PC conectado.
+//Usa las ultimas LOG_FILAS filas del ultimo arreglo de flash como un anillo:
+//cada fila lleva un encabezado con secuencia y CRC y LOG_POR_FILA resumenes.
+//Las filas se escriben enteras (borrado + programacion en una sola operacion
+//del SPC), asi que un corte de energia deja a lo sumo una fila con CRC malo,
+//que se descarta. Al llenar el anillo se pisa la fila mas vieja: el desgaste
+//queda repartido por igual entre todas.
+//Cada LOG_HIST_CADA filas de resumenes (y al borrar el histograma) se intercala
+//una fila con el histograma de potencia (tipo LOG_TIPO_HISTOGRAMA); al arrancar
+//se sigue acumulando desde la mas nueva.
+#define LOG_FILAS           128u
+#define LOG_INTERVALO_S     10u     //segundos por resumen
+#define LOG_MAGIA           0x474Cu //"LG"
+#define LOG_VERSION         1u
+#define LOG_HIST_CADA       8u      //filas de resumenes entre histogramas (16 min)
+
+//Tipo de fila (campo "tipo" del encabezado; antes era reservado y valia 0)
+enum
+{
+    LOG_TIPO_RESUMEN = 0u,
+    LOG_TIPO_HISTOGRAMA
+};
+
+//Resumen de un intervalo (20 bytes)
+typedef struct
+{
+    uint32 t_s;             //segundos desde el arranque al cerrar el intervalo
+    uint16 vbus_mv;         //promedio
+    int16  corriente_dma;   //promedio en decimas de mA, saturado en +-3.2767 A
+    int16  p_med_cw;        //potencia promedio en centesimas de W
+    int16  p_min_cw;
+    int16  p_max_cw;
+    uint16 n;               //ventanas de 1 s incluidas
+    int32  energia_mwh;     //energia acumulada al cerrar
+} Log_Resumen;
+
+//Encabezado de fila (16 bytes); el CRC cubre toda la fila salvo el propio campo
+typedef struct
+{
+    uint16 magia;
+    uint8  version;
+    uint8  n;               //resumenes validos en la fila
+    uint32 secuencia;       //crece con cada fila escrita
+    uint16 arranque;        //numero de arranque del equipo
+    uint16 intervalo_s;
+    uint16 tipo;            //LOG_TIPO_*
+    uint16 crc;
+} Log_Encabezado;
+
+#define LOG_POR_FILA        ((CY_FLASH_SIZEOF_ROW - sizeof(Log_Encabezado)) / sizeof(Log_Resumen))
+
+typedef struct
+{
+    Log_Encabezado enc;
+    Log_Resumen    r[LOG_POR_FILA];
+} Log_Fila;
+
+//Fila de histograma: ms por cubeta (histograma.h); enc.n va en 0
+typedef struct
+{
+    Log_Encabezado enc;
+    uint32         ms[HIST_N];
+} Log_Histograma;
+
+void   Registro_Start(void);
+void   Registro_Agregar(const Resumen *r, int32 energia_mwh, uint32 t_s);
+void   Registro_Tarea(void);
+void   Registro_Volcar(void);
+void   Registro_Guardar_Histograma(void);
+const uint32 *Registro_Histograma(void);
+void   Registro_Volcar_Poll(void);
+uint8  Registro_Volcando(void);
+uint32 Registro_PeorEscritura(void);
+uint32 Registro_Filas(void);
+uint16 Registro_Arranque(void);
+
+#endif /* REGISTRO_H */
+/* [] END OF FILE */
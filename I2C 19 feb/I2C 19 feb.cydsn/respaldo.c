@@ -0,0 +1,168 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "respaldo.h"
+#include "config.h"
+#include "timebase.h"
+#include <string.h>
+#include <stddef.h>
+
+#define RESPALDO_BLOQUE     (CY_EM_EEPROM_EEPROM_DATA_LEN)
+#define RESPALDO_REDUNDANTE 1u
+#define RESPALDO_FISICO     (RESPALDO_BLOQUE * 2u * RESPALDO_DESGASTE * (1u + RESPALDO_REDUNDANTE))
+
+//Umbral del detector digital: 1.70 V + 250 mV por paso (0x00..0x0F)
+#define LVD_PASO(mv)        ((uint8)((((mv) - 1700u) / 250u) & 0x0Fu))
+
+typedef char respaldo_entra_en_bloque[(sizeof(Respaldo) <= RESPALDO_BLOQUE) ? 1 : -1];
+
+CY_ALIGN(CY_EM_EEPROM_FLASH_SIZEOF_ROW)
+static const uint8 almacen[RESPALDO_FISICO] = {0u};
+
+static cy_stc_eeprom_context_t contexto;
+static Respaldo ultimo;         //lo que hay en la EEPROM (o el punto de partida)
+static uint8  habilitado;
+static uint8  en_corte;         //ya se guardo por este disparo del LVD
+static uint32 proximo_s;
+static uint32 tiempo_base;      //tiempo acumulado hasta este arranque
+static uint32 uptime_s;         //segundos de este arranque (sin la vuelta de los 49 dias de Timebase_Now)
+static uint32 t_ant;
+static uint32 resto;
+static uint32 escrituras;
+static uint32 cortes;
+
+static uint16 Crc_Respaldo(const Respaldo *r){
+    return Crc16((const uint8 *)r,(uint16)offsetof(Respaldo,crc));
+}
+
+//Lee el ultimo registro y arma el detector de baja tension. No escribe nada:
+//el nuevo arranque queda contado en el proximo guardado.
+uint8 Respaldo_Init(void){
+    cy_stc_eeprom_config_t cfg;
+    uint8 origen;
+
+    memset(&ultimo,0,sizeof(ultimo));
+    cfg.eepromSize=RESPALDO_BLOQUE;
+    cfg.wearLevelingFactor=RESPALDO_DESGASTE;
+    cfg.redundantCopy=RESPALDO_REDUNDANTE;
+    cfg.blockingWrite=1u;
+    cfg.userFlashStartAddr=(uint32)almacen;
+    habilitado=0u;
+    if(Cy_Em_EEPROM_Init(&cfg,&contexto)!=CY_EM_EEPROM_SUCCESS){
+        origen=RESPALDO_ERROR;
+    }else{
+        habilitado=1u;
+        if(Cy_Em_EEPROM_Read(0u,&ultimo,sizeof(Respaldo),&contexto)!=CY_EM_EEPROM_SUCCESS){
+            origen=RESPALDO_ERROR;
+        }else if(ultimo.magia!=RESPALDO_MAGIA){
+            origen=RESPALDO_VACIO;
+        }else if((ultimo.version!=RESPALDO_VERSION) || (ultimo.crc!=Crc_Respaldo(&ultimo))){
+            origen=RESPALDO_INVALIDO;
+        }else{
+            origen=RESPALDO_GUARDADO;
+        }
+        if(origen!=RESPALDO_GUARDADO){
+            memset(&ultimo,0,sizeof(ultimo));
+        }
+    }
+    ultimo.arranques++;
+    tiempo_base=ultimo.tiempo_s;
+    uptime_s=0u;
+    resto=0u;
+    t_ant=Timebase_Now();
+    proximo_s=RESPALDO_PERIODO_S;
+    en_corte=0u;
+    (void)CyVdStickyStatus(CY_VD_LVID);     //descarta disparos anteriores
+    CyVdLvDigitEnable(0u,LVD_PASO(RESPALDO_LVD_MV));
+    return origen;
+}
+
+//Ultimo registro guardado; justo despues de Respaldo_Init, el leido de la EEPROM
+const Respaldo *Respaldo_Get(void){
+    return &ultimo;
+}
+
+//Tiempo de funcionamiento total: lo guardado mas lo que va de este arranque
+uint32 Respaldo_Tiempo(void){
+    return tiempo_base+uptime_s;
+}
+
+//Bloquea mientras programa las dos filas (decenas de ms), asi que se llama desde
+//una tarea. energia_mwms es el total completo, no lo de este arranque.
+cy_en_em_eeprom_status_t Respaldo_Guardar(int64 energia_mwms, uint8 motivo){
+    cy_en_em_eeprom_status_t r;
+    Respaldo nuevo;
+
+    if(habilitado==0u){
+        return CY_EM_EEPROM_WRITE_FAIL;
+    }
+    memset(&nuevo,0,sizeof(nuevo));
+    nuevo.magia=RESPALDO_MAGIA;
+    nuevo.version=RESPALDO_VERSION;
+    nuevo.contador=ultimo.contador+1u;
+    nuevo.arranques=ultimo.arranques;
+    nuevo.motivo=motivo;
+    if(motivo==RESPALDO_BORRADO){
+        tiempo_base=0u-uptime_s;    //el tiempo total vuelve a contar desde cero
+        nuevo.energia_mwms=0;
+    }else{
+        nuevo.energia_mwms=energia_mwms;
+    }
+    nuevo.tiempo_s=tiempo_base+uptime_s;
+    nuevo.crc=Crc_Respaldo(&nuevo);
+    r=Cy_Em_EEPROM_Write(0u,&nuevo,sizeof(Respaldo),&contexto);
+    if(r==CY_EM_EEPROM_SUCCESS){
+        ultimo=nuevo;
+        escrituras++;
+    }
+    return r;
+}
+
+//Tarea periodica: guardado de emergencia si disparo el LVD, o punto de control
+void Respaldo_Tarea(int64 energia_mwms){
+    uint32 ahora=Timebase_Now();
+
+    resto+=ahora-t_ant;
+    t_ant=ahora;
+    while(resto>=TIMEBASE_TICK_HZ){
+        resto-=TIMEBASE_TICK_HZ;
+        uptime_s++;
+    }
+    if(habilitado==0u){
+        return;
+    }
+    if((CyVdStickyStatus(CY_VD_LVID) & CY_VD_LVID)!=0u){
+        if(en_corte==0u){
+            en_corte=1u;
+            cortes++;
+            (void)Respaldo_Guardar(energia_mwms,RESPALDO_CORTE);
+        }
+        return;
+    }
+    //la tension volvio sin llegar al reset: se rearma para el proximo corte
+    if((en_corte!=0u) && ((CyVdRealTimeStatus() & CY_VD_LVID)==0u)){
+        en_corte=0u;
+    }
+    if((int32)(uptime_s-proximo_s)>=0){
+        proximo_s=uptime_s+RESPALDO_PERIODO_S;
+        (void)Respaldo_Guardar(energia_mwms,RESPALDO_PUNTO);
+    }
+}
+
+uint32 Respaldo_Escrituras(void){
+    return escrituras;
+}
+
+uint32 Respaldo_Cortes(void){
+    return cortes;
+}
+
+/* [] END OF FILE */
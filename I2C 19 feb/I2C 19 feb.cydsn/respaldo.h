@@ -0,0 +1,84 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef RESPALDO_H
+#define RESPALDO_H
+
+#include "project.h"
+#include "cy_em_eeprom.h"
+
+//Respaldo de la energia acumulada y del tiempo de funcionamiento en una EEPROM
+//emulada propia (separada de la configuracion).
+//
+//Cuando se guarda:
+// - cada RESPALDO_PERIODO_S segundos (punto de control), y
+// - una vez al caer Vddd por debajo de RESPALDO_LVD_MV (detector digital de baja
+//   tension, sin reset), mientras el capacitor de la fuente todavia alcanza.
+//
+//Escrituras por dia: 86400/900 = 96 puntos de control. Cada uno programa 2 filas
+//(la fila y su copia redundante) y el desgaste se reparte en RESPALDO_DESGASTE
+//filas, asi que cada fila fisica se borra 96/8 = 12 veces por dia: ~22 años para
+//las 100 000 escrituras que garantiza la flash. Los cortes detectados por el LVD
+//suman uno por corte.
+//
+//Perdida en el peor caso:
+// - corte lento con LVD: nada, salvo la energia medida despues del disparo. Hace
+//   falta que la fuente sostenga Vddd por encima de 1.8 V unos 40 ms (dos filas)
+//   mas la latencia de la tarea (hasta 10 ms + la tarea mas larga).
+// - reset sin aviso (pin XRES, watchdog, falla, corte brusco): lo acumulado desde
+//   el ultimo punto de control, hasta RESPALDO_PERIODO_S. A fondo de escala del
+//   INA219 (32 V x 3.2 A = 102 W) son 25.6 Wh y 15 min de tiempo.
+#define RESPALDO_MAGIA      0x4552u     //"RE"
+#define RESPALDO_VERSION    1u
+#define RESPALDO_PERIODO_S  900u
+#define RESPALDO_LVD_MV     ((CYDEV_VDDD_MV * 9u) / 10u)
+#define RESPALDO_DESGASTE   8u
+
+//Motivo del ultimo guardado
+enum
+{
+    RESPALDO_PUNTO = 0u,    //punto de control periodico
+    RESPALDO_CORTE,         //disparo del detector de baja tension
+    RESPALDO_BORRADO        //el usuario puso los contadores en cero
+};
+
+//Origen de los contadores al arrancar
+enum
+{
+    RESPALDO_GUARDADO = 0u, //registro valido leido de la EEPROM
+    RESPALDO_VACIO,         //primer arranque
+    RESPALDO_INVALIDO,      //magia, version o CRC no coinciden
+    RESPALDO_ERROR          //fallo la EEPROM emulada
+};
+
+typedef struct
+{
+    uint16 magia;
+    uint16 version;
+    uint32 contador;        //guardados en la vida del equipo
+    int64  energia_mwms;    //energia acumulada (mismas unidades que Totales)
+    uint32 tiempo_s;        //tiempo de funcionamiento acumulado
+    uint32 arranques;
+    uint8  motivo;
+    uint8  reservado;
+    uint16 crc;             //CRC-16/CCITT de todo lo anterior
+} Respaldo;
+
+uint8  Respaldo_Init(void);
+const Respaldo *Respaldo_Get(void);
+uint32 Respaldo_Tiempo(void);
+void   Respaldo_Tarea(int64 energia_mwms);
+cy_en_em_eeprom_status_t Respaldo_Guardar(int64 energia_mwms, uint8 motivo);
+uint32 Respaldo_Escrituras(void);
+uint32 Respaldo_Cortes(void);
+
+#endif /* RESPALDO_H */
+/* [] END OF FILE */
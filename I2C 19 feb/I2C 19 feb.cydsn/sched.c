@@ -0,0 +1,111 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "sched.h"
+
+static Tarea *tareas;
+static uint8 n_tareas;
+static Tarea_Fn tarea_idle;
+static Sched_Despacho despacho;
+static uint32 pasadas_idle;
+
+void Sched_Init(Tarea *tabla, uint8 n, Tarea_Fn idle){
+    uint8 i;
+
+    tareas=tabla;
+    n_tareas=n;
+    tarea_idle=idle;
+    despacho=0;
+    pasadas_idle=0u;
+    for(i=0;i<n;i++){
+        Tarea *t=&tabla[i];
+        if(t->hz!=0u){
+            Rate_Init(&t->rate,t->hz);
+            if(t->plazo==0u){
+                t->plazo=t->rate.periodo;
+            }
+        }
+        t->pendiente=0u;
+        t->tarde=0u;
+        t->peor_ticks=0u;
+    }
+}
+
+//Se puede llamar desde una ISR. Si el evento ya estaba pendiente se conserva
+//el instante del primero, que es desde donde corre el plazo.
+void Sched_Signal(uint8 id){
+    Tarea *t;
+
+    if(id>=n_tareas){
+        return;
+    }
+    t=&tareas[id];
+    if(t->pendiente==0u){
+        t->t_evento=Timebase_Now();
+        t->pendiente=1u;
+    }
+}
+
+//Funcion que se llama antes de cada tarea con su indice (por ejemplo para subir
+//el reloj o para que el watchdog sepa que tarea esta corriendo)
+void Sched_SetDespacho(Sched_Despacho fn){
+    despacho=fn;
+}
+
+static void Ejecutar(Tarea *t, uint32 liberada){
+    uint32 duracion;
+
+    if(despacho!=0){
+        despacho((uint8)(t-tareas));
+    }
+    t->fn();
+    duracion=Timebase_Now()-liberada;
+    if(duracion>t->peor_ticks){
+        t->peor_ticks=duracion;
+    }
+    if((t->plazo!=0u) && (duracion>t->plazo)){
+        t->tarde++;
+    }
+}
+
+//Una pasada: ejecuta la tarea lista de mayor prioridad, o el idle si no hay ninguna
+void Sched_Run(void){
+    uint8 i;
+
+    for(i=0;i<n_tareas;i++){
+        Tarea *t=&tareas[i];
+
+        if(t->pendiente!=0u){
+            uint32 liberada=t->t_evento;
+            t->pendiente=0u;
+            t->rate.ejecuciones++;
+            Ejecutar(t,liberada);
+            return;
+        }
+        if(t->hz!=0u){
+            uint32 vencimiento=t->rate.proximo;
+            if(Rate_Due(&t->rate)){
+                Ejecutar(t,vencimiento);
+                return;
+            }
+        }
+    }
+    pasadas_idle++;
+    if(tarea_idle!=0){
+        tarea_idle();
+    }
+}
+
+uint32 Sched_IdleCount(void){
+    return pasadas_idle;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,229 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef SENSOR_H
+#define SENSOR_H
+
+//Familia de sensores de corriente y tension de TI con el mismo mapa basico
+//(0x00 configuracion, 0x01 shunt o corriente, 0x02 bus). El modelo se elige al
+//compilar con SENSOR_MODELO; cada uno define su escala en punto fijo y como se
+//arman los modos disparado y rapido, todo con macros y funciones inline, asi que
+//no hay despacho en tiempo de ejecucion. Compilando para el PC con -DSENSOR_HOST
+//no se incluye project.h (lo usa el simulador de registros, sensor_sim.c).
+#define SENSOR_INA219       0
+#define SENSOR_INA226       1
+#define SENSOR_INA260       2       //shunt de 2 mOhm integrado: lee corriente directa
+#define SENSOR_INA3221      3       //tres canales: se usa solo el canal 1
+
+#if !defined(SENSOR_MODELO)
+    #define SENSOR_MODELO   SENSOR_INA219
+#endif
+
+#if defined(SENSOR_HOST)
+    #include <stdint.h>
+    typedef uint8_t  uint8;
+    typedef uint16_t uint16;
+    typedef uint32_t uint32;
+    typedef int16_t  int16;
+    typedef int32_t  int32;
+    typedef int64_t  int64;
+    #define CY_INLINE   inline
+#else
+    #include "project.h"
+#endif
+
+#define SENSOR_DIRECCION    0x40u   //A0=A1=GND en todos
+#define SENSOR_DIRECCION_SALIDA 0x41u   //A0=VS: segundo sensor del modo eficiencia, mismo modelo
+#define SENSOR_REG_CONFIG   0x00u
+#define SENSOR_REG_SHUNT    0x01u   //INA260: corriente; INA3221: shunt del canal 1
+#define SENSOR_REG_BUS      0x02u   //INA3221: bus del canal 1
+#define SENSOR_MODO_MASK    0x0007u
+#define SENSOR_MODO_DISPARADO 0x0003u   //shunt y bus, una conversion por escritura
+#define SENSOR_MODO_SHUNT   0x0005u     //shunt (o corriente) continuo
+#define SENSOR_MODO_CONTINUO 0x0007u    //shunt y bus continuo (el modo normal)
+#define SENSOR_RESET        0x8000u     //RST: vuelve a los valores de fabrica
+
+//Por modelo:
+//  SENSOR_NOMBRE           texto para los reportes
+//  SENSOR_CONFIG_DEFECTO   registro de configuracion con que arranca el medidor
+//  SENSOR_SHUNT_NV         nV por cuenta del registro del shunt, o
+//  SENSOR_CORRIENTE_UA     uA por cuenta si el registro ya es corriente
+//  SENSOR_BUS_DESPLAZA     bits a descartar del registro del bus
+//  SENSOR_BUS_UV           uV por cuenta del bus ya desplazado
+//  SENSOR_CONFIG_RESERVADO bits de la configuracion que deben ir en cero
+//  Sensor_Config_Rapido    solo shunt, conversion mas corta (captura)
+//  Sensor_Conversion_us    duracion de una conversion completa segun la configuracion
+//                          (en los modos de solo shunt o solo bus cuenta uno solo)
+//  Sensor_Config_Adc       paso 0..SENSOR_PASOS_ADC-1 del barrido de tiempos de
+//                          conversion y promedios (bus y shunt iguales, continuo)
+#if (SENSOR_MODELO == SENSOR_INA219)
+
+    #define SENSOR_NOMBRE           "INA219"
+    #define SENSOR_CONFIG_DEFECTO   0x399Fu     //32 V, +-320 mV, 12 bits, continuo (reset)
+    #define SENSOR_SHUNT_NV         10000       //10 uV
+    #define SENSOR_BUS_DESPLAZA     3u          //CNVR y OVF en los bits 1..0
+    #define SENSOR_BUS_UV           4000u       //4 mV
+    #define SENSOR_CONFIG_RESERVADO 0x4000u     //bit 14 sin uso
+
+    //BRNG y PG se conservan; SADC=0 (9 bits, 84 us)
+    static CY_INLINE uint16 Sensor_Config_Rapido(uint16 c){
+        return (uint16)((c & 0x3800u) | SENSOR_MODO_SHUNT);
+    }
+
+    //Campo BADC/SADC: resolucion de 9 a 12 bits, o promedio de 2^n muestras de 12
+    static CY_INLINE uint32 Sensor_Adc_us(uint16 campo){
+        static const uint16 bits_us[4]={84u,148u,276u,532u};
+
+        if((campo & 0x8u)==0u){
+            return bits_us[campo & 0x3u];
+        }
+        return 532u<<(campo & 0x7u);
+    }
+
+    //9 a 12 bits y promedios de 2 a 128 (hasta 68 ms por conversion)
+    #define SENSOR_PASOS_ADC    11u
+
+    static CY_INLINE uint16 Sensor_Config_Adc(uint16 c, uint8 paso){
+        static const uint8 campos[SENSOR_PASOS_ADC]={0x0u,0x1u,0x2u,0x3u,0x9u,0xAu,0xBu,0xCu,0xDu,0xEu,0xFu};
+        uint16 campo=campos[paso];
+
+        return (uint16)((c & 0x3800u) | (campo<<7) | (campo<<3) | 0x0007u);
+    }
+
+    static CY_INLINE uint32 Sensor_Conversion_us(uint16 c){
+        uint32 us=0u;
+
+        if((c & 0x1u)!=0u){
+            us+=Sensor_Adc_us((uint16)((c>>3) & 0xFu));
+        }
+        if((c & 0x2u)!=0u){
+            us+=Sensor_Adc_us((uint16)((c>>7) & 0xFu));
+        }
+        return us;
+    }
+
+#elif (SENSOR_MODELO == SENSOR_INA226) || (SENSOR_MODELO == SENSOR_INA260) || (SENSOR_MODELO == SENSOR_INA3221)
+
+    #if (SENSOR_MODELO == SENSOR_INA226)
+        #define SENSOR_NOMBRE           "INA226"
+        #define SENSOR_CONFIG_DEFECTO   0x4127u     //sin promedio, 1.1 ms bus y shunt, continuo (reset)
+        #define SENSOR_SHUNT_NV         2500        //2.5 uV
+        #define SENSOR_BUS_DESPLAZA     0u
+        #define SENSOR_BUS_UV           1250u       //1.25 mV
+    #elif (SENSOR_MODELO == SENSOR_INA260)
+        #define SENSOR_NOMBRE           "INA260"
+        #define SENSOR_CONFIG_DEFECTO   0x6127u     //igual que el INA226 (reset)
+        #define SENSOR_CORRIENTE_UA     1250        //1.25 mA
+        #define SENSOR_BUS_DESPLAZA     0u
+        #define SENSOR_BUS_UV           1250u
+    #else
+        #define SENSOR_NOMBRE           "INA3221"
+        #define SENSOR_CONFIG_DEFECTO   0x4127u     //solo canal 1; el reset (0x7127) convierte los tres
+        #define SENSOR_SHUNT_NV         5000        //40 uV en los bits 15..3 = 5 uV por cuenta
+        #define SENSOR_BUS_DESPLAZA     3u
+        #define SENSOR_BUS_UV           8000u       //8 mV
+    #endif
+    #define SENSOR_CONFIG_RESERVADO 0x0000u     //INA226/INA260: bits 14..12 de solo lectura
+
+    //Se conservan los bits 14..12 (canales del INA3221) y VBUSCT; AVG=0 y el
+    //shunt a 140 us
+    static CY_INLINE uint16 Sensor_Config_Rapido(uint16 c){
+        return (uint16)((c & 0x71C0u) | SENSOR_MODO_SHUNT);
+    }
+
+    //Tiempos de 140 us a 8.2 ms sin promedio, y despues promedios de 4 a 128 con
+    //el tiempo mas corto (los promedios largos con tiempos largos tardan segundos)
+    #define SENSOR_PASOS_ADC    12u
+
+    static CY_INLINE uint16 Sensor_Config_Adc(uint16 c, uint8 paso){
+        uint16 ct=(paso<8u) ? paso : 0u;
+        uint16 prom=(paso<8u) ? 0u : (uint16)(paso-7u);
+
+        return (uint16)((c & 0x7000u) | (prom<<9) | (ct<<6) | (ct<<3) | 0x0007u);
+    }
+
+    //(VBUSCT + VSHCT) x AVG, y en el INA3221 por cada canal habilitado
+    static CY_INLINE uint32 Sensor_Conversion_us(uint16 c){
+        static const uint16 ct_us[8]={140u,204u,332u,588u,1100u,2116u,4156u,8244u};
+        static const uint16 promedio[8]={1u,4u,16u,64u,128u,256u,512u,1024u};
+        uint32 us=0u;
+
+        if((c & 0x1u)!=0u){
+            us+=ct_us[(c>>3) & 0x7u];
+        }
+        if((c & 0x2u)!=0u){
+            us+=ct_us[(c>>6) & 0x7u];
+        }
+        us*=promedio[(c>>9) & 0x7u];
+
+        #if (SENSOR_MODELO == SENSOR_INA3221)
+            us*=(uint32)(((c>>14) & 1u)+((c>>13) & 1u)+((c>>12) & 1u));
+        #endif
+        return us;
+    }
+
+#else
+    #error "SENSOR_MODELO desconocido"
+#endif
+
+static CY_INLINE uint16 Sensor_Config_Disparado(uint16 c){
+    return (uint16)((c & (uint16)~SENSOR_MODO_MASK) | SENSOR_MODO_DISPARADO);
+}
+
+//Configuracion que se puede guardar: sin reset, shunt y bus en continuo (los
+//demas modos los pone la adquisicion sola), sin bits reservados y, en el
+//INA3221, con el canal 1 habilitado
+static CY_INLINE uint8 Sensor_Config_Valida(uint16 c){
+    if((c & (SENSOR_RESET | SENSOR_CONFIG_RESERVADO))!=0u){
+        return 0u;
+    }
+    if((c & SENSOR_MODO_MASK)!=SENSOR_MODO_CONTINUO){
+        return 0u;
+    }
+    #if (SENSOR_MODELO == SENSOR_INA3221)
+        if((c & 0x4000u)==0u){
+            return 0u;
+        }
+    #endif
+    return 1u;
+}
+
+//Registro del bus -> lo que viaja en Crudo.bus
+static CY_INLINE uint16 Sensor_Bus(uint16 reg){
+    return (uint16)(reg>>SENSOR_BUS_DESPLAZA);
+}
+
+static CY_INLINE uint16 Sensor_Bus_mv(uint16 bus){
+    return (uint16)(((uint32)bus*SENSOR_BUS_UV)/1000u);
+}
+
+//Registro del shunt (complemento a 2) -> corriente en uA
+static CY_INLINE int32 Sensor_Corriente_ua(int16 shunt, int32 rshunt_mohm){
+    #if defined(SENSOR_CORRIENTE_UA)
+        (void)rshunt_mohm;
+        return (int32)shunt*SENSOR_CORRIENTE_UA;
+    #else
+        return ((int32)shunt*SENSOR_SHUNT_NV)/rshunt_mohm;
+    #endif
+}
+
+//Inversa: corriente en uA -> cuentas del registro del shunt (umbral de la captura)
+static CY_INLINE int32 Sensor_Shunt_Crudo(int32 ua, int32 rshunt_mohm){
+    #if defined(SENSOR_CORRIENTE_UA)
+        (void)rshunt_mohm;
+        return ua/SENSOR_CORRIENTE_UA;
+    #else
+        return (int32)(((int64)ua*rshunt_mohm)/SENSOR_SHUNT_NV);
+    #endif
+}
+
+#endif /* SENSOR_H */
+/* [] END OF FILE */
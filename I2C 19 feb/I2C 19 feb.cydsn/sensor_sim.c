@@ -0,0 +1,249 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+//Simulador a nivel de registros del sensor elegido en sensor.h, para el PC. No
+//es parte del firmware (no esta en el .cyprj): arma el mapa de registros a
+//partir de una corriente y una tension "reales", y el lado del medidor lo lee con
+//las mismas funciones inline que usa medicion.c. Hace dos cosas:
+//  - barrido sin ruido de corriente y tension para validar la escala de punto fijo
+//  - banco de pruebas tasa/resolucion: por cada configuracion del ADC, tiempo de
+//    conversion, tasa maxima con el tick de 1 ms, error, ruido y bits efectivos
+//El ruido de entrada es un modelo (blanco, baja con la raiz del tiempo de
+//integracion), no una medicion del chip.
+//
+//Uso: gcc -DSENSOR_HOST -DSENSOR_MODELO=SENSOR_INA226 -o sim sensor_sim.c -lm && ./sim
+#if defined(SENSOR_HOST)
+
+#include "sensor.h"
+#include <stdio.h>
+#include <math.h>
+
+#define SIM_TICK_HZ         1000u       //isr_timer: una lectura por tick como maximo
+#define SIM_LECTURAS        2000u
+#define SIM_CORRIENTE_A     0.5
+#define SIM_TENSION_V       12.0
+
+#if defined(SENSOR_CORRIENTE_UA)
+    #define SIM_RSHUNT_MOHM 2           //shunt integrado
+#else
+    #define SIM_RSHUNT_MOHM 100         //el del modulo (RSHUNT_MOHM en medicion.h)
+#endif
+
+//Ruido de entrada supuesto en el shunt (uV rms) con la configuracion por defecto
+#if (SENSOR_MODELO == SENSOR_INA219)
+    #define SIM_RUIDO_UV    10.0
+#elif (SENSOR_MODELO == SENSOR_INA3221)
+    #define SIM_RUIDO_UV    20.0
+#else
+    #define SIM_RUIDO_UV    2.5
+#endif
+
+static uint16 registros[8];
+static double corriente_a;
+static double tension_v;
+static double ruido_uv;
+static uint32 semilla = 12345u;
+
+static double Uniforme(void){
+    semilla=semilla*1664525u+1013904223u;
+    return ((double)(semilla>>8)+0.5)/16777216.0;
+}
+
+static double Gauss(void){
+    return sqrt(-2.0*log(Uniforme()))*cos(6.283185307179586*Uniforme());
+}
+
+static int32 Saturar16(double v){
+    long n=lround(v);
+
+    return (int32)((n>32767L) ? 32767L : ((n<-32768L) ? -32768L : n));
+}
+
+//Una conversion: llena los registros de shunt y bus segun la configuracion
+static void Sim_Convertir(void){
+    uint16 c=registros[SENSOR_REG_CONFIG];
+    double t=(double)Sensor_Conversion_us(c);
+    double t_ref=(double)Sensor_Conversion_us(SENSOR_CONFIG_DEFECTO);
+    double shunt_uv=corriente_a*SIM_RSHUNT_MOHM*1000.0+ruido_uv*sqrt(t_ref/t)*Gauss();
+    int32 cuentas;
+    double bus;
+
+    #if defined(SENSOR_CORRIENTE_UA)
+        cuentas=Saturar16((shunt_uv*1000.0/SIM_RSHUNT_MOHM)/SENSOR_CORRIENTE_UA);
+    #elif (SENSOR_MODELO == SENSOR_INA3221)
+        cuentas=Saturar16(shunt_uv*1000.0/(SENSOR_SHUNT_NV*8))*8;    //bits 2..0 en cero
+    #else
+        cuentas=Saturar16(shunt_uv*1000.0/SENSOR_SHUNT_NV);
+        #if (SENSOR_MODELO == SENSOR_INA219)
+            if((c & 0x0040u)==0u){
+                //SADC de 9 a 11 bits: el mismo LSB pero se pierden los bits bajos
+                double paso=(double)(1<<(3u-((c>>3) & 0x3u)));
+                cuentas=(int32)(lround(cuentas/paso)*paso);
+            }
+        #endif
+    #endif
+    registros[SENSOR_REG_SHUNT]=(uint16)(int16)cuentas;
+    bus=tension_v*1000000.0/SENSOR_BUS_UV;
+    if(bus<0.0){
+        bus=0.0;
+    }
+    registros[SENSOR_REG_BUS]=(uint16)((uint32)lround(bus)<<SENSOR_BUS_DESPLAZA);
+    #if (SENSOR_MODELO == SENSOR_INA219)
+        registros[SENSOR_REG_BUS]|=0x0002u;     //CNVR
+    #endif
+}
+
+static void Sim_Escribir(uint8 reg, uint16 v){
+    if(reg!=SENSOR_REG_CONFIG){
+        return;
+    }
+    registros[SENSOR_REG_CONFIG]=((v & 0x8000u)!=0u) ? SENSOR_CONFIG_DEFECTO : v;
+    if((v & SENSOR_MODO_MASK)==SENSOR_MODO_DISPARADO){
+        Sim_Convertir();
+    }
+}
+
+//En modo continuo cada lectura ve una conversion nueva (se lee mas lento que se convierte)
+static uint16 Sim_Leer(uint8 reg){
+    uint16 modo=registros[SENSOR_REG_CONFIG] & SENSOR_MODO_MASK;
+
+    if((reg==SENSOR_REG_SHUNT) && (modo>=4u)){
+        Sim_Convertir();
+    }
+    return registros[reg & 7u];
+}
+
+//Lado del medidor: lo mismo que Medicion_Convertir sin la calibracion
+static void Leer(int32 *ua, uint16 *mv){
+    *ua=Sensor_Corriente_ua((int16)Sim_Leer(SENSOR_REG_SHUNT),SIM_RSHUNT_MOHM);
+    *mv=Sensor_Bus_mv(Sensor_Bus(Sim_Leer(SENSOR_REG_BUS)));
+}
+
+//Corriente de fondo de escala del registro del shunt, en uA
+static double Fondo_ua(void){
+    #if defined(SENSOR_CORRIENTE_UA)
+        return 32767.0*SENSOR_CORRIENTE_UA;
+    #else
+        return 32767.0*SENSOR_SHUNT_NV/SIM_RSHUNT_MOHM;
+    #endif
+}
+
+//Hasta el 95 % del fondo de escala de corriente y de 0 a 24 V
+static void Barrido(void){
+    double peor_ua=0.0,peor_mv=0.0;
+    double paso_a=Fondo_ua()*0.95e-6/300.0;
+    int i;
+
+    ruido_uv=0.0;
+    Sim_Escribir(SENSOR_REG_CONFIG,SENSOR_CONFIG_DEFECTO);
+    for(i=-300;i<=300;i++){
+        int32 ua;
+        uint16 mv;
+        double e_ua,e_mv;
+
+        corriente_a=i*paso_a;
+        tension_v=(i+300)*0.04;
+        Leer(&ua,&mv);
+        e_ua=fabs(ua-corriente_a*1e6);
+        e_mv=fabs(mv-tension_v*1e3);
+        if(e_ua>peor_ua){
+            peor_ua=e_ua;
+        }
+        if(e_mv>peor_mv){
+            peor_mv=e_mv;
+        }
+    }
+    printf("#BARRIDO %s +-%.2f A, 0..24 V: error maximo %.0f uA, %.1f mV\n",SENSOR_NOMBRE,
+           300.0*paso_a,peor_ua,peor_mv);
+}
+
+//Bits efectivos: rango completo sobre el ruido (con piso en el de cuantizacion)
+//La ventana es de SIM_LECTURAS ticks: con conversiones mas lentas que el tick
+//entran menos lecturas, y con menos de 2 no hay ruido ni bits que estimar (N/A).
+static void Medir(uint16 c, const char *nombre){
+    uint32 us=Sensor_Conversion_us(c);
+    uint32 hz=(us!=0u) ? (1000000u/us) : SIM_TICK_HZ;
+    double suma=0.0,suma2=0.0,media,sigma,lsb,bits;
+    uint32 k,n;
+
+    if(hz>SIM_TICK_HZ){
+        hz=SIM_TICK_HZ;
+    }
+    n=(hz*SIM_LECTURAS)/SIM_TICK_HZ;
+    if(n==0u){
+        printf("%-14s 0x%04X %7lu %5lu %9s %8s %6s\n",nombre,c,(unsigned long)us,(unsigned long)hz,
+               "N/A","N/A","N/A");
+        return;
+    }
+    Sim_Escribir(SENSOR_REG_CONFIG,c);
+    for(k=0;k<n;k++){
+        int32 ua;
+        uint16 mv;
+
+        Leer(&ua,&mv);
+        suma+=ua;
+        suma2+=(double)ua*ua;
+    }
+    media=suma/n;
+    if(n<2u){
+        printf("%-14s 0x%04X %7lu %5lu %9.0f %8s %6s\n",nombre,c,(unsigned long)us,(unsigned long)hz,
+               media-corriente_a*1e6,"N/A","N/A");
+        return;
+    }
+    sigma=sqrt(fmax(suma2/n-media*media,0.0));
+    lsb=2.0*Fondo_ua()/65536.0;
+    #if (SENSOR_MODELO == SENSOR_INA3221)
+        lsb*=8.0;
+    #endif
+    bits=log2(2.0*Fondo_ua()/(fmax(sigma,lsb/sqrt(12.0))*sqrt(12.0)));
+    printf("%-14s 0x%04X %7lu %5lu %9.0f %8.1f %6.1f\n",nombre,c,(unsigned long)us,(unsigned long)hz,
+           media-corriente_a*1e6,sigma,bits);
+}
+
+int main(void){
+    Barrido();
+    ruido_uv=SIM_RUIDO_UV;
+    corriente_a=SIM_CORRIENTE_A;
+    tension_v=SIM_TENSION_V;
+    printf("#BANCO %s %.2f A %.1f V rshunt=%u mOhm ruido=%.1f uV\n",SENSOR_NOMBRE,corriente_a,tension_v,
+           SIM_RSHUNT_MOHM,ruido_uv);
+    printf("%-14s %6s %7s %5s %9s %8s %6s\n","adc","config","conv_us","hz","error_ua","ruido_ua","bits");
+#if (SENSOR_MODELO == SENSOR_INA219)
+    Medir(0x3807u,"9 bits");
+    Medir(0x388Fu,"10 bits");
+    Medir(0x3917u,"11 bits");
+    Medir(0x399Fu,"12 bits");
+    Medir(0x3D57u,"prom 4");
+    Medir(0x3E67u,"prom 16");
+    Medir(0x3FFFu,"prom 128");
+#else
+    {
+        static const uint8 ct[] = {0u, 2u, 4u, 4u, 4u, 7u, 7u};
+        static const uint8 prom[] = {0u, 0u, 0u, 1u, 2u, 0u, 3u};
+        static const uint16 n_prom[] = {1u, 4u, 16u, 64u};
+        uint8 k;
+
+        for(k=0;k<sizeof(ct);k++){
+            char nombre[16];
+            uint16 c=(uint16)((SENSOR_CONFIG_DEFECTO & 0xF000u) | ((uint16)prom[k]<<9) |
+                              ((uint16)ct[k]<<6) | ((uint16)ct[k]<<3) | 0x0007u);
+
+            (void)snprintf(nombre,sizeof(nombre),"ct%u x%u",ct[k],n_prom[prom[k]]);
+            Medir(c,nombre);
+        }
+    }
+#endif
+    Medir(Sensor_Config_Rapido(SENSOR_CONFIG_DEFECTO),"rapido");
+    return 0;
+}
+
+#endif /* SENSOR_HOST */
+/* [] END OF FILE */
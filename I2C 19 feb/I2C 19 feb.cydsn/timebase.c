@@ -0,0 +1,217 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "timebase.h"
+
+static volatile uint32 ticks = 0;
+static volatile uint32 ticks_alto = 0;     //vueltas de ticks (cada ~49 dias)
+static volatile Timebase_Hook hook = 0;
+
+#if defined(CY_TIMER_Timer_1_H)
+
+#include "perfil.h"
+#include "ramfunc.h"
+
+//Timer_1 cuenta el reloj "timer" (1 MHz, ver Timebase_Start) y su terminal count
+//dispara isr_timer cada 1000 cuentas
+EN_RAM CY_ISR(Timebase_Isr){
+    PERFIL_INICIO(PF_ISR_TIMER);
+    if(++ticks==0u){
+        ticks_alto++;
+    }
+    if(hook!=0){
+        hook();
+    }
+    isr_timer_ClearPending();
+    PERFIL_FIN(PF_ISR_TIMER);
+}
+
+//La fuente del reloj "timer" sale del divisor que dejo el diseño para 5 kHz
+void Timebase_Start(void){
+    uint32 fuente=TIMEBASE_CLK_DISENO_HZ*((uint32)timer_GetDividerRegister()+1u);
+
+    timer_Start();
+    timer_SetDividerValue((uint16)(fuente/TIMEBASE_CLK_HZ));
+    Timer_1_Start();
+    Timer_1_WritePeriod(TIMEBASE_PERIODO);
+    Timer_1_WriteCounter(TIMEBASE_PERIODO);
+    isr_timer_StartEx(Timebase_Isr);
+}
+
+//us transcurridos dentro del tick en curso, y si el contador ya dio la vuelta
+//sin que la ISR lo haya contado (interrupciones apagadas o llamado desde otra
+//ISR de la misma prioridad, como I2C_ISR). Con las interrupciones apagadas: la
+//lectura del contador UDB pasa por la FIFO de captura y no puede partirse.
+static uint32 Subtick_us(uint8 *vuelta){
+    uint32 us=(uint32)(TIMEBASE_PERIODO-Timer_1_ReadCounter());
+
+    //el registro SETPEND del NVIC se lee como "pendiente"
+    *vuelta=(uint8)(((*isr_timer_INTC_SET_PD & (uint32)isr_timer__INTC_MASK)!=0u) &&
+                    (us<(TIMEBASE_US_TICK/2u)));
+    return us;
+}
+
+#else
+
+//Sin Timer_1 en el diseño: el SysTick ya viene configurado a 1 ms por CySysTickInit()
+static void Timebase_Isr(void){
+    if(++ticks==0u){
+        ticks_alto++;
+    }
+    if(hook!=0){
+        hook();
+    }
+}
+
+void Timebase_Start(void){
+    CySysTickStart();
+    (void)CySysTickSetCallback(0u, Timebase_Isr);
+}
+
+//Igual que con Timer_1, con el SysTick (cuenta hacia abajo desde LOAD)
+static uint32 Subtick_us(uint8 *vuelta){
+    uint32 carga=SysTick->LOAD+1u;
+    uint32 us=((carga-1u-SysTick->VAL)*TIMEBASE_US_TICK)/carga;
+
+    *vuelta=(uint8)(((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)!=0u) && (us<(TIMEBASE_US_TICK/2u)));
+    return us;
+}
+
+#endif
+
+void Timebase_SetHook(Timebase_Hook fn){
+    hook=fn;
+}
+
+uint32 Timebase_Now(void){
+    //lectura de 32 bits alineada: atomica en el Cortex-M3
+    return ticks;
+}
+
+//Reloj monotono en us desde el arranque. Ticks y contador se leen juntos con las
+//interrupciones apagadas; si el contador ya dio la vuelta y la ISR todavia no
+//corrio se cuenta el tick que falta. Se puede llamar desde una ISR.
+uint64 Timebase_Us64(void){
+    uint8 estado = CyEnterCriticalSection();
+    uint64 ms = ((uint64)ticks_alto << 32) | ticks;
+    uint8 vuelta;
+    uint32 us = Subtick_us(&vuelta);
+
+    CyExitCriticalSection(estado);
+    if(vuelta != 0u){
+        ms++;
+    }
+    return (ms * TIMEBASE_US_TICK) + us;
+}
+
+//Los 32 bits bajos (dan la vuelta cada ~71 min): para diferencias cortas
+uint32 Timebase_Us(void){
+    return (uint32)Timebase_Us64();
+}
+
+//Adelanta la base de tiempo lo que estuvo detenido el contador (por ejemplo
+//durante el modo Sleep, en que el reloj del timer no corre)
+void Timebase_Sumar(uint32 n){
+    uint8 estado = CyEnterCriticalSection();
+    uint32 antes = ticks;
+
+    ticks += n;
+    if(ticks < antes){
+        ticks_alto++;
+    }
+    CyExitCriticalSection(estado);
+}
+
+static void Jitter_Reset(Jitter *j){
+    j->min = 0;
+    j->max = 0;
+    j->retraso = 0u;
+    j->n = 0u;
+}
+
+//Registra una ejecucion: desvio del periodo real respecto al nominal y atraso
+//desde el vencimiento. Todo en ticks del contador de hardware.
+static void Jitter_Registrar(Rate *r, uint32 ahora, uint32 vencido){
+    Jitter *j = &r->jitter_act;
+    uint32 retraso = ahora - vencido;
+
+    if(retraso > j->retraso){
+        j->retraso = retraso;
+    }
+    if(r->ejecuciones != 0u){
+        int32 desvio = (int32)(ahora - r->ultimo) - (int32)r->periodo;
+        if((j->n == 0u) || (desvio < j->min)){
+            j->min = desvio;
+        }
+        if((j->n == 0u) || (desvio > j->max)){
+            j->max = desvio;
+        }
+        j->n++;
+    }
+    r->ultimo = ahora;
+}
+
+void Rate_Init(Rate *r, uint16 hz){
+    if(hz == 0u){
+        hz = 1u;
+    }
+    r->periodo = TIMEBASE_TICK_HZ / hz;
+    if(r->periodo == 0u){
+        r->periodo = 1u;
+    }
+    r->proximo = Timebase_Now() + r->periodo;
+    r->origen = r->proximo;
+    r->ultimo = 0u;
+    r->ejecuciones = 0u;
+    r->ejecuciones_ant = 0u;
+    r->perdidas = 0u;
+    r->lograda_hz = 0u;
+    Jitter_Reset(&r->jitter_act);
+    Jitter_Reset(&r->jitter);
+}
+
+//Devuelve 1 si la tasa vencio. El siguiente vencimiento se calcula desde el
+//anterior (no desde "ahora") para no acumular retraso; si se atraso mas de un
+//periodo se descartan los vencimientos perdidos en vez de ejecutarlos en rafaga.
+uint8 Rate_Due(Rate *r){
+    uint32 ahora = Timebase_Now();
+    uint32 vencido = r->proximo;
+
+    if((int32)(ahora - vencido) < 0){
+        return 0u;
+    }
+    Jitter_Registrar(r, ahora, vencido);
+    r->proximo += r->periodo;
+    if((int32)(ahora - r->proximo) >= 0){
+        r->perdidas += ((ahora - r->proximo) / r->periodo) + 1u;
+        r->proximo = ahora + r->periodo;
+    }
+    r->ejecuciones++;
+    return 1u;
+}
+
+//Llamar una vez por segundo: guarda cuantas ejecuciones hubo desde la ultima llamada
+//y el jitter acumulado en ese intervalo
+void Rate_Measure(Rate *r){
+    r->lograda_hz = (uint16)(r->ejecuciones - r->ejecuciones_ant);
+    r->ejecuciones_ant = r->ejecuciones;
+    r->jitter = r->jitter_act;
+    Jitter_Reset(&r->jitter_act);
+}
+
+//Corrimiento de fase (ticks) de los vencimientos respecto a la grilla original.
+//Es 0 mientras no se pierda ningun vencimiento: como el proximo se calcula desde
+//el anterior, la deriva a largo plazo queda solo en la tolerancia del reloj.
+uint32 Rate_Fase(const Rate *r){
+    return (r->proximo - r->origen) % r->periodo;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,107 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "vigia.h"
+#include "timebase.h"
+
+CY_NOINIT static Vigia_Diag diag;
+
+static Vigia_Diag ultimo;       //copia del diagnostico tal como quedo antes del reset
+static uint8  causa;            //CyResetStatus del arranque
+static uint32 requerido;
+static uint32 presentes;
+
+//Lee el diagnostico del arranque anterior y arranca el watchdog. "requeridas" es
+//la mascara (bit = indice de tarea) de las que tienen que presentarse.
+void Vigia_Start(uint32 requeridas){
+    causa=CyResetStatus;
+    if((diag.magia==VIGIA_MAGIA) && (diag.magia_neg==(uint32)~VIGIA_MAGIA)){
+        ultimo=diag;
+        if((causa & CY_RESET_WD)!=0u){
+            diag.reinicios_wdt++;
+        }
+        diag.seg_total+=VIGIA_PERDIDA_S;
+    }else{
+        diag.magia=VIGIA_MAGIA;
+        diag.magia_neg=(uint32)~VIGIA_MAGIA;
+        diag.reinicios_wdt=0u;
+        diag.seg_total=0u;
+        diag.seg_datos=0u;
+        ultimo=diag;
+        ultimo.tarea=VIGIA_IDLE;
+        ultimo.anterior=VIGIA_IDLE;
+        ultimo.ciclo=0u;
+        ultimo.t_ms=0u;
+    }
+    diag.tarea=VIGIA_IDLE;
+    diag.anterior=VIGIA_IDLE;
+    requerido=requeridas;
+    presentes=0u;
+    CyWdtStart(VIGIA_TIMEOUT,CYWDT_LPMODE_NOCHANGE);
+}
+
+//La tarea que estaba en curso termino: se presenta, y si ya estan todas se
+//alimenta el watchdog
+static void Presentar(void){
+    if(diag.tarea!=VIGIA_IDLE){
+        presentes|=((uint32)1u<<diag.tarea);
+        diag.anterior=diag.tarea;
+    }
+    if((presentes & requerido)==requerido){
+        CyWdtClear();
+        presentes=0u;
+    }
+}
+
+//Antes de cada tarea (desde el despacho del planificador)
+void Vigia_Entrar(uint8 id){
+    Presentar();
+    diag.ciclo=DWT->CYCCNT;
+    diag.t_ms=Timebase_Now();
+    diag.tarea=id;
+}
+
+//Desde Idle(): ninguna tarea en curso
+void Vigia_Idle(void){
+    Presentar();
+    diag.tarea=VIGIA_IDLE;
+}
+
+//Registro de reset del arranque (CY_RESET_WD, CY_RESET_SW, ...)
+uint8 Vigia_Causa(void){
+    return causa;
+}
+
+const Vigia_Diag *Vigia_Ultimo(void){
+    return &ultimo;
+}
+
+uint32 Vigia_Reinicios(void){
+    return diag.reinicios_wdt;
+}
+
+//Una vez por segundo: la disponibilidad es la fraccion de segundos con datos
+//desde el encendido, contando como perdidos los que lleva cada reinicio
+void Vigia_Segundo(uint8 hubo_datos){
+    diag.seg_total++;
+    if(hubo_datos!=0u){
+        diag.seg_datos++;
+    }
+}
+
+uint32 Vigia_Disponibilidad_Permil(void){
+    if(diag.seg_total==0u){
+        return 1000u;
+    }
+    return (uint32)(((uint64)diag.seg_datos*1000u)/diag.seg_total);
+}
+
+/* [] END OF FILE */
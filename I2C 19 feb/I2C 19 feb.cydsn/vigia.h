@@ -0,0 +1,52 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef VIGIA_H
+#define VIGIA_H
+
+#include "project.h"
+
+//Supervision con el watchdog del PSoC. El watchdog solo se alimenta cuando todas
+//las tareas periodicas de la mascara terminaron al menos una vez desde la ultima
+//vez: si una tarea se cuelga (o una de mayor prioridad no la deja correr) el
+//equipo se reinicia en 2-3 s. La tarea en curso y un sello de tiempo quedan en
+//RAM sin inicializar (.noinit), asi que despues del reinicio se sabe quien fue.
+#define VIGIA_TIMEOUT       CYWDT_1024_TICKS    //2048-3072 ms
+#define VIGIA_IDLE          0xFFu               //ninguna tarea en curso
+#define VIGIA_MAGIA         0x56494749u         //"VIGI"
+#define VIGIA_PERDIDA_S     3u                  //segundos sin datos que se cargan por cada reinicio
+
+//Diagnostico que sobrevive a los reinicios que no cortan la alimentacion
+typedef struct
+{
+    uint32 magia;
+    uint32 magia_neg;       //~magia: distingue RAM valida de basura de encendido
+    uint8  tarea;           //tarea en curso (VIGIA_IDLE si ninguna)
+    uint8  anterior;        //la que corrio antes
+    uint16 reservado;
+    uint32 ciclo;           //DWT CYCCNT al entrar a la tarea
+    uint32 t_ms;            //Timebase_Now() al entrar a la tarea
+    uint32 reinicios_wdt;   //reinicios por watchdog desde el ultimo encendido
+    uint32 seg_total;       //segundos desde el encendido (incluye los perdidos en reinicios)
+    uint32 seg_datos;       //segundos con al menos una muestra
+} Vigia_Diag;
+
+void   Vigia_Start(uint32 requeridas);
+void   Vigia_Entrar(uint8 id);
+void   Vigia_Idle(void);
+uint8  Vigia_Causa(void);
+const Vigia_Diag *Vigia_Ultimo(void);
+uint32 Vigia_Reinicios(void);
+void   Vigia_Segundo(uint8 hubo_datos);
+uint32 Vigia_Disponibilidad_Permil(void);
+
+#endif /* VIGIA_H */
+/* [] END OF FILE */
@@ -12,25 +12,68 @@
 #include "project.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include "timebase.h"
+#include "sched.h"
+#include "ringbuf.h"
 #define SLAVE_ADRESS 0x40
+
+//Tasas independientes (Hz). Este diseño no tiene Timer_1: la base de tiempo es el SysTick
+#define RATE_MUESTREO_HZ      20u   //lectura del INA219
+#define RATE_ESTADISTICA_HZ   1u    //cierre de la ventana de promedios
+#define RATE_UART_HZ          1u    //envio de la trama al PC
+#define RATE_LCD_HZ           4u    //refresco de la LCD
+
+//Tareas del planificador, en orden de prioridad
+enum
+{
+    T_ADQUIRIR = 0u,
+    T_ESTADISTICA,
+    T_COMANDOS,         //evento de isr_Rx
+    T_TRAMA,
+    T_LCD,
+    T_TASAS,
+    N_TAREAS
+};
 uint8 result=0;
 
 int16 Datos,Datos2,Voltaje_Shunt=0;
 float32 factor_lsb_Corriente=0;
 int16 Corriente,Voltaje,Potencia=0;
-int flag=0;
+volatile int flag=0;
+int pedir_tasas=0;
+
+RING_DEFINIR(Ring_Rx, char, 32u)
+Ring_Rx cola_rx;
+
+//Ventana de estadistica
+int32 suma_voltaje,suma_corriente,suma_potencia=0;
+uint16 n_ventana=0;
+int16 Voltaje_Prom,Corriente_Prom,Potencia_Prom=0;
 //INTERRUPCION DE RECEPCION///
 
 
+//La ISR solo encola los bytes recibidos y despierta la tarea de comandos
 CY_ISR(Rx){
 
+    while((UART_ReadRxStatus() & UART_RX_STS_FIFO_NOTEMPTY)!=0u){
+        (void)Ring_Rx_Push(&cola_rx,(char)UART_ReadRxData());
+    }
+    Sched_Signal(T_COMANDOS);
+     isr_Rx_ClearPending();
+}
+
+void Atender_Comando(){
     char Value_Init;
-    Value_Init=UART_GetChar();
-    if(Value_Init == 'a'){
-      flag=1;
     
+    while(Ring_Rx_Pop(&cola_rx,&Value_Init)){
+        if(Value_Init == 'a'){
+          flag=1;
+        
+        }
+        if(Value_Init == 'r'){
+          pedir_tasas=1;
+        }
     }
-     isr_Rx_ClearPending();
 }
 
 
@@ -114,18 +157,7 @@ void Read_Values(int Address_Measure){
         }
        //datos convertidos
   }
-int main(void)
-{
-    CyGlobalIntEnable; /* Enable global interrupts. */
-    isr_Rx_StartEx(Rx);
-
-     /* Place your initialization/startup code here (e.g. MyInst_Start()) */
-    UART_Start();
-    i2c_Start();
-    LCD_Start();
-    for(;;)
-    {
-       Calc_Factor_LSB(3);
+void Adquirir(){
         do{
         i2c_MasterSendStart(SLAVE_ADRESS, i2c_WRITE_XFER_MODE);
         }while(result!=i2c_MSTR_NO_ERROR);
@@ -137,58 +169,107 @@ int main(void)
            Read_Values(0x03);
            Read_Values(0x04);
            i2c_MasterSendStop();
-           if(flag==1){
+           suma_voltaje+=Voltaje;
+           suma_corriente+=Corriente;
+           suma_potencia+=Potencia;
+           n_ventana++;
+}
+void Cerrar_Ventana(){
+    if(n_ventana==0){
+        return;
+    }
+    Voltaje_Prom=(int16)(suma_voltaje/n_ventana);
+    Corriente_Prom=(int16)(suma_corriente/n_ventana);
+    Potencia_Prom=(int16)(suma_potencia/n_ventana);
+    suma_voltaje=0;
+    suma_corriente=0;
+    suma_potencia=0;
+    n_ventana=0;
+}
+void Enviar_Trama(){
               int8 temp=0; 
-              UART_PutChar(Voltaje);
+              if(flag!=1){
+                return;
+              }
+              UART_PutChar(Voltaje_Prom);
               CyDelay(1);
-              temp=(Voltaje>>8);
+              temp=(Voltaje_Prom>>8);
               UART_PutChar(temp);
               CyDelay(1);
-              UART_PutChar(Corriente);
+              UART_PutChar(Corriente_Prom);
               CyDelay(1);
-              temp=(Corriente>>8);
+              temp=(Corriente_Prom>>8);
               UART_PutChar(temp);
               CyDelay(1);
-              UART_PutChar(Potencia);
+              UART_PutChar(Potencia_Prom);
               CyDelay(1);
-              temp=(Potencia>>8);
+              temp=(Potencia_Prom>>8);
               UART_PutChar(temp);
-           }
+}
+void Refrescar_LCD(){
          LCD_Position(0,0);
-         char shunt[2];
+         char shunt[8];
          sprintf(shunt,"%d",Voltaje_Shunt);
          LCD_PrintString(shunt);
-     /// ENVIAR DATOS POR MODULO UART
-        ///1-ESTABLECER COMUNICACION
-        
-        ///2-DETECTAR LA SEÑAL PARA ENVIAR LOS DATOS
-        
-        
-        ///3-A ENVIAR LA PRIMERA TRAMA CON LOS BITS MAS SIGNIFICATIVOS DE BUS_VOLTAGE
-        
-        ///3-B ENVIAR LA SEGUNDA TRAMA CON LOS BITS MENOS SIGNIFICATIVOS DE BUS_VOLTAGE
-        
-        ///4-A ENVIAR LA PRIMERA TRAMA CON LOS BITS MAS SIGINIFICATIVOS DE CORRIENTE
-        
-        ///4-B ENVIAR LA SEGUNDA TRAMA CON LOS BITS MENOS SIGNIFICATIVOS DE CORRIENTE
-        
-        ///5-A ENVIAR LA PRIMERA TRAMA CON LOS BITS MAS SIGNIFICATIVOS DE POTENCIA
-        
-        
-        ///5-B ENVIAR LA SEGUNDA TRAMA CON LOS BITS MENOS SIGNIFICATIVOS DE VOLTAJE
-        
-        ///HACER UN RETARDO DE 996 MS
-     ///Establecer la   
-     
-        
-   
-     
-      
-             
-    
-        //i2c_MasterWriteByte(
-        
-        /* Place your application code here. */
+}
+void Medir_Tasas();
+Tarea tareas[N_TAREAS]={
+    TAREA_PERIODICA("adq",Adquirir,RATE_MUESTREO_HZ),
+    TAREA_PERIODICA("est",Cerrar_Ventana,RATE_ESTADISTICA_HZ),
+    TAREA_EVENTO("cmd",Atender_Comando,TIMEBASE_MS(50)),
+    TAREA_PERIODICA("tx",Enviar_Trama,RATE_UART_HZ),
+    TAREA_PERIODICA("lcd",Refrescar_LCD,RATE_LCD_HZ),
+    TAREA_PERIODICA("tasas",Medir_Tasas,1u),
+};
+//Por tarea: tasa lograda / ejecuciones fuera de plazo / peor tiempo en ticks.
+//Se envia solo si el PC la pide con 'r', para no mezclarla con las tramas binarias.
+void Medir_Tasas(){
+    static uint32 idle_ant=0;
+    uint32 idle=Sched_IdleCount();
+    char linea[64];
+    Rate *r;
+    uint8 k;
+    for(k=0;k<N_TAREAS;k++){
+        Rate_Measure(&tareas[k].rate);
+    }
+    if(pedir_tasas==1){
+        pedir_tasas=0;
+        UART_PutString("#TAREAS");
+        for(k=0;k<N_TAREAS;k++){
+            Tarea *t=&tareas[k];
+            sprintf(linea," %s=%u/%lu/%lu",t->nombre,t->rate.lograda_hz,t->tarde,t->peor_ticks);
+            UART_PutString(linea);
+        }
+        sprintf(linea," idle=%lu\r\n",idle-idle_ant);
+        UART_PutString(linea);
+        sprintf(linea,"#COLAS rx=%lu/%lu\r\n",Ring_Rx_Maximo(&cola_rx),cola_rx.desbordes);
+        UART_PutString(linea);
+        //Jitter de la trama de 1 Hz: desvio del periodo min..max / atraso maximo,
+        //y corrimiento de fase respecto a la grilla del SysTick
+        r=&tareas[T_TRAMA].rate;
+        sprintf(linea,"#RELOJ t=%lu trama=%ld..%ld/%lu",Timebase_Now(),r->jitter.min,r->jitter.max,r->jitter.retraso);
+        UART_PutString(linea);
+        sprintf(linea," fase=%lu perdidas=%lu\r\n",Rate_Fase(r),r->perdidas);
+        UART_PutString(linea);
+    }
+    idle_ant=idle;
+}
+int main(void)
+{
+    CyGlobalIntEnable; /* Enable global interrupts. */
+
+     /* Place your initialization/startup code here (e.g. MyInst_Start()) */
+    UART_Start();
+    i2c_Start();
+    LCD_Start();
+    Timebase_Start();
+    Calc_Factor_LSB(3);
+    Sched_Init(tareas,N_TAREAS,0);
+    isr_Rx_StartEx(Rx);
+    for(;;)
+    {
+        //Cada tarea corre a su propia cadencia hasta terminar
+        Sched_Run();
     }
 }
 
@@ -0,0 +1,102 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef RINGBUF_H
+#define RINGBUF_H
+
+#include "project.h"
+
+//Colas circulares sin bloqueo de un productor y un consumidor (ISR -> tarea o
+//tarea -> ISR). El tamaño es potencia de 2: los indices corren libres en 32 bits
+//y se enmascaran al acceder, asi "lleno" y "vacio" no se confunden.
+//Solo el productor escribe "cabeza" y solo el consumidor escribe "cola"; la
+//barrera __DMB asegura que el dato este en memoria antes de publicar el indice.
+//Los contadores que pueden tocar ambos lados (maximo, desbordes) se actualizan
+//con LDREX/STREX.
+
+static CY_INLINE void Atomico_Sumar(volatile uint32 *p, uint32 v){
+    uint32 act;
+    do{
+        act=__LDREXW((volatile uint32_t *)p);
+    }while(__STREXW(act+v,(volatile uint32_t *)p)!=0u);
+}
+
+static CY_INLINE void Atomico_Maximo(volatile uint32 *p, uint32 v){
+    uint32 act;
+    do{
+        act=__LDREXW((volatile uint32_t *)p);
+        if(v<=act){
+            __CLREX();
+            return;
+        }
+    }while(__STREXW(v,(volatile uint32_t *)p)!=0u);
+}
+
+static CY_INLINE uint32 Atomico_Intercambiar(volatile uint32 *p, uint32 v){
+    uint32 act;
+    do{
+        act=__LDREXW((volatile uint32_t *)p);
+    }while(__STREXW(v,(volatile uint32_t *)p)!=0u);
+    return act;
+}
+
+//Define el tipo Nombre y sus funciones Nombre_Push/Pop/Count/Maximo/ResetMaximo
+#define RING_DEFINIR(Nombre, Tipo, N)                                           \
+typedef struct                                                                  \
+{                                                                               \
+    Tipo buf[(N)];                                                              \
+    volatile uint32 cabeza;     /* solo la escribe el productor */              \
+    volatile uint32 cola;       /* solo la escribe el consumidor */             \
+    volatile uint32 maximo;     /* maxima ocupacion observada */                \
+    volatile uint32 desbordes;  /* elementos descartados por cola llena */      \
+} Nombre;                                                                       \
+typedef char Nombre##_tam_potencia_de_2[((((N) & ((N) - 1u)) == 0u) && ((N) > 1u)) ? 1 : -1]; \
+                                                                                \
+static CY_INLINE uint8 Nombre##_Push(Nombre *r, Tipo v){                        \
+    uint32 cab=r->cabeza;                                                       \
+    uint32 ocupado=cab-r->cola;                                                 \
+    if(ocupado>=(uint32)(N)){                                                   \
+        Atomico_Sumar(&r->desbordes,1u);                                        \
+        return 0u;                                                              \
+    }                                                                           \
+    r->buf[cab&((uint32)(N)-1u)]=v;                                             \
+    __DMB();                                                                    \
+    r->cabeza=cab+1u;                                                           \
+    Atomico_Maximo(&r->maximo,ocupado+1u);                                      \
+    return 1u;                                                                  \
+}                                                                               \
+                                                                                \
+static CY_INLINE uint8 Nombre##_Pop(Nombre *r, Tipo *v){                        \
+    uint32 col=r->cola;                                                         \
+    if(col==r->cabeza){                                                         \
+        return 0u;                                                              \
+    }                                                                           \
+    __DMB();                                                                    \
+    *v=r->buf[col&((uint32)(N)-1u)];                                            \
+    __DMB();                                                                    \
+    r->cola=col+1u;                                                             \
+    return 1u;                                                                  \
+}                                                                               \
+                                                                                \
+static CY_INLINE uint32 Nombre##_Count(const Nombre *r){                        \
+    return r->cabeza-r->cola;                                                   \
+}                                                                               \
+                                                                                \
+static CY_INLINE uint32 Nombre##_Maximo(const Nombre *r){                       \
+    return r->maximo;                                                           \
+}                                                                               \
+                                                                                \
+static CY_INLINE uint32 Nombre##_ResetMaximo(Nombre *r){                        \
+    return Atomico_Intercambiar(&r->maximo,Nombre##_Count(r));                  \
+}
+
+#endif /* RINGBUF_H */
+/* [] END OF FILE */
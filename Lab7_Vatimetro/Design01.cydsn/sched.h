@@ -0,0 +1,46 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef SCHED_H
+#define SCHED_H
+
+#include "project.h"
+#include "timebase.h"
+
+//Planificador cooperativo: cada tarea corre hasta terminar. El orden de la tabla
+//es la prioridad; en cada pasada se ejecuta la primera tarea lista.
+typedef void (*Tarea_Fn)(void);
+typedef void (*Sched_Despacho)(uint8 id);
+
+typedef struct
+{
+    const char *nombre;
+    Tarea_Fn    fn;
+    uint16      hz;             //0 = tarea solo por evento
+    uint32      plazo;          //ticks permitidos entre liberacion y fin; 0 = un periodo
+    Rate        rate;           //vencimientos de la tarea periodica
+    volatile uint8  pendiente;  //evento señalado (desde una ISR o desde otra tarea)
+    volatile uint32 t_evento;   //tick en que se señalo el evento
+    uint32      tarde;          //ejecuciones que terminaron fuera de plazo
+    uint32      peor_ticks;     //peor tiempo desde la liberacion hasta el fin
+} Tarea;
+
+#define TAREA_PERIODICA(n,f,h)  {.nombre=(n), .fn=(f), .hz=(h)}
+#define TAREA_EVENTO(n,f,p)     {.nombre=(n), .fn=(f), .plazo=(p)}
+
+void   Sched_Init(Tarea *tabla, uint8 n, Tarea_Fn idle);
+void   Sched_SetDespacho(Sched_Despacho fn);
+void   Sched_Signal(uint8 id);
+void   Sched_Run(void);
+uint32 Sched_IdleCount(void);
+
+#endif /* SCHED_H */
+/* [] END OF FILE */
@@ -0,0 +1,67 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include "project.h"
+
+//Base de tiempo unica del vatimetro: un tick de 1 ms.
+//Si el diseño tiene Timer_1 (reloj "timer" de 5 kHz + isr_timer en su salida tc)
+//se usa ese contador; si no, se usa el SysTick del Cortex-M3.
+#define TIMEBASE_TICK_HZ        1000u
+#define TIMEBASE_MS(ms)         ((uint32)(ms) * TIMEBASE_TICK_HZ / 1000u)
+
+#if defined(CY_TIMER_Timer_1_H)
+    #define TIMEBASE_CLK_HZ     5000u   //frecuencia del reloj "timer"
+    #define TIMEBASE_PERIODO    ((uint16)((TIMEBASE_CLK_HZ / TIMEBASE_TICK_HZ) - 1u))
+#endif
+
+//Jitter de una tasa en un intervalo de medicion, en ticks
+typedef struct
+{
+    int32  min;             //menor desvio del periodo medido respecto al nominal
+    int32  max;             //mayor desvio
+    uint32 retraso;         //mayor atraso entre el vencimiento y la ejecucion
+    uint32 n;               //periodos medidos
+} Jitter;
+
+//Tarea periodica con tasa configurable. Cada tasa guarda su proximo vencimiento
+//en ticks absolutos y cuenta cuantas veces se ejecuto, para reportar la tasa lograda.
+typedef struct
+{
+    uint32 periodo;         //ticks entre ejecuciones
+    uint32 proximo;         //tick absoluto del siguiente vencimiento
+    uint32 origen;          //primer vencimiento: la grilla ideal es origen + k*periodo
+    uint32 ultimo;          //tick de la ultima ejecucion
+    uint32 ejecuciones;     //total de ejecuciones
+    uint32 ejecuciones_ant; //total en la ultima medicion de tasa
+    uint32 perdidas;        //vencimientos saltados por llegar tarde
+    uint16 lograda_hz;      //ejecuciones en el ultimo segundo
+    Jitter jitter_act;      //jitter que se esta acumulando
+    Jitter jitter;          //jitter del ultimo intervalo medido
+} Rate;
+
+//Funcion que se llama desde la ISR del tick (por ejemplo para arrancar una lectura)
+typedef void (*Timebase_Hook)(void);
+
+void   Timebase_Start(void);
+uint32 Timebase_Now(void);
+void   Timebase_Sumar(uint32 n);
+void   Timebase_SetHook(Timebase_Hook fn);
+
+void   Rate_Init(Rate *r, uint16 hz);
+uint8  Rate_Due(Rate *r);
+void   Rate_Measure(Rate *r);
+uint32 Rate_Fase(const Rate *r);
+
+#endif /* TIMEBASE_H */
+/* [] END OF FILE */